@@ -0,0 +1,220 @@
+// bench.c — 스케줄러 마이크로 벤치마크 (make bench), 결과는 CSV 로 stdout
+// SPDX-License-Identifier: MIT
+//
+// 행 하나 = 설정 하나를 reps 번 잰 결과. median / p99 는 호출 한 번의 wall time (ns),
+// per_iter_ns 는 median / n. 모든 경우 pool 을 미리 만들어 두고 잰다 (oneshot 만 예외).
+#define _GNU_SOURCE
+#include "include/parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+static inline long ns_now(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static const struct { const char *name; int opt; } scheds[] = {
+    { "shared",   PARALLEL_OPT_SCHED_SHARED },
+    { "steal",    PARALLEL_OPT_SCHED_STEAL },
+    { "guided",   PARALLEL_OPT_SCHED_GUIDED },
+    { "adaptive", PARALLEL_OPT_SCHED_ADAPTIVE },
+    { "static",   PARALLEL_OPT_SCHED_STATIC },
+};
+#define NSCHED ((int)(sizeof(scheds) / sizeof(scheds[0])))
+
+// 반복 하나의 일: 의존 사슬이라 컴파일러가 접을 수 없다. cost 단위 하나 ≈ 곱셈-덧셈 32 번
+static inline unsigned long spin_work(long units, unsigned long x){
+    for (long u = 0; u < units; ++u)
+        for (int k = 0; k < 32; ++k) { x = x * 6364136223846793005UL + 1442695040888963407UL; asm volatile("" : "+r"(x)); }
+    return x;
+}
+
+typedef struct {
+    long n;
+    long cost;          // 반복당 단위 수
+    int skew;           // 1 이면 앞 1/8 이 16 배 무겁다
+    unsigned long sink[64] __attribute__((aligned(64)));
+} Work;
+
+static void empty_range(long start, long stop, void *ud){
+    (void)start; (void)stop; (void)ud;
+}
+
+static void empty_body(long i, void *ud){
+    (void)i; (void)ud;
+    asm volatile("" ::: "memory");
+}
+
+static void work_range(long start, long stop, void *ud){
+    Work *w = (Work*)ud;
+    unsigned long x = (unsigned long)start;
+    for (long i = start; i < stop; ++i) {
+        long c = w->cost;
+        if (w->skew && i < w->n / 8) c *= 16;
+        x = spin_work(c, x);
+    }
+    int t = parallel_worker_index();
+    w->sink[(t < 0 ? 0 : t) & 63] += x;   // 결과를 남겨 루프가 사라지지 않게
+}
+
+static int cmp_long(const void *a, const void *b){
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct { int reps; long *t; } Timer;
+
+static void report(const char *bench, const char *sched, int threads, int pin, long chunk,
+                   long n, long cost, Timer *tm){
+    qsort(tm->t, (size_t)tm->reps, sizeof(long), cmp_long);
+    long med = tm->t[tm->reps / 2];
+    int  i99 = (tm->reps * 99 + 99) / 100 - 1;
+    if (i99 >= tm->reps) i99 = tm->reps - 1;
+    long p99 = tm->t[i99];
+    printf("%s,%s,%d,%d,%ld,%ld,%ld,%d,%ld,%ld,%.3f\n", bench, sched, threads, pin, chunk, n, cost,
+           tm->reps, med, p99, n > 0 ? (double)med / (double)n : 0.0);
+    fflush(stdout);
+}
+
+// pool 위에서 같은 루프를 reps 번 (+ 워밍업 1 번)
+static int time_pool(parallel_pool *pool, Timer *tm, long n, long chunk, int opt,
+                     pfor_range_fn fn, void *ud){
+    for (int r = -1; r < tm->reps; ++r) {
+        long t0 = ns_now();
+        if (parallel_pool_for_range(pool, 0, n, chunk, opt, fn, ud) < 0) return -1;
+        long dt = ns_now() - t0;
+        if (r >= 0) tm->t[r] = dt;
+    }
+    return 0;
+}
+
+static parallel_pool *make_pool(int threads, int pin){
+    parallel_pool *pool = parallel_pool_create(threads, pin ? PARALLEL_OPT_PIN_CORE : 0);
+    if (!pool) fprintf(stderr, "parallel_pool_create(%d) failed\n", threads);
+    return pool;
+}
+
+// 1. 빈 body 호출당 비용: 워커 수만큼만 반복 (워커 깨우기 + 완료 대기), oneshot 은 스레드 생성 포함
+static int bench_empty(Timer *tm, int maxthr, int pin){
+    parallel_pool *pool = make_pool(maxthr, pin);
+    if (!pool) return -1;
+    int thr = parallel_pool_size(pool);
+    for (int s = 0; s < NSCHED; ++s) {
+        if (time_pool(pool, tm, thr, 1, scheds[s].opt, empty_range, NULL) != 0) { parallel_pool_destroy(pool); return -1; }
+        report("empty_call", scheds[s].name, thr, pin, 1, thr, 0, tm);
+    }
+    parallel_pool_destroy(pool);
+
+    for (int r = -1; r < tm->reps; ++r) {
+        long t0 = ns_now();
+        if (parallel_for(0, thr, 1, thr, pin ? PARALLEL_OPT_PIN_CORE : 0, empty_body, NULL) < 0) return -1;
+        long dt = ns_now() - t0;
+        if (r >= 0) tm->t[r] = dt;
+    }
+    report("empty_oneshot", "shared", thr, pin, 1, thr, 0, tm);
+    return 0;
+}
+
+// 2. 반복당 분배 비용: 빈 body, chunk 크기별
+static int bench_dispatch(Timer *tm, int maxthr, int pin, long n){
+    static const long chunks[] = { 1, 4, 16, 64, 256, 1024, 4096 };
+    parallel_pool *pool = make_pool(maxthr, pin);
+    if (!pool) return -1;
+    int thr = parallel_pool_size(pool);
+    for (int s = 0; s < NSCHED; ++s) {
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); ++c) {
+            if (time_pool(pool, tm, n, chunks[c], scheds[s].opt, empty_range, NULL) != 0) { parallel_pool_destroy(pool); return -1; }
+            report("dispatch", scheds[s].name, thr, pin, chunks[c], n, 0, tm);
+        }
+    }
+    parallel_pool_destroy(pool);
+    return 0;
+}
+
+// 3~5. 고른 / 치우친 일, 스레드 수 1..maxthr (2 의 거듭제곱 + maxthr), 핀닝 여부
+static int bench_work(Timer *tm, const char *bench, int maxthr, int pin, long n, long cost, int skew, int scale){
+    Work *w = NULL;
+    if (posix_memalign((void**)&w, 64, sizeof(*w)) != 0) return -1;
+    memset(w, 0, sizeof(*w));
+    w->n = n; w->cost = cost; w->skew = skew;
+    const long chunk = 16;
+    int rc = 0;
+    for (int thr = scale ? 1 : maxthr; thr <= maxthr && rc == 0; thr = thr < maxthr && thr * 2 > maxthr ? maxthr : thr * 2) {
+        parallel_pool *pool = make_pool(thr, pin);
+        if (!pool) { rc = -1; break; }
+        int got = parallel_pool_size(pool);
+        for (int s = 0; s < NSCHED && rc == 0; ++s) {
+            rc = time_pool(pool, tm, n, chunk, scheds[s].opt, work_range, w);
+            if (rc == 0) report(bench, scheds[s].name, got, pin, chunk, n, cost, tm);
+        }
+        parallel_pool_destroy(pool);
+        if (thr == maxthr) break;
+    }
+    free(w);
+    return rc;
+}
+
+static void usage(const char *prog){
+    fprintf(stderr,
+        "Usage: %s [-r reps=31] [-t maxthreads=cores] [-n iters=1048576] [-c cost=4] [-b list] [-q]\n"
+        "  -b list  comma list of: empty,dispatch,scaling,pin,skew (default all)\n"
+        "  -q       quick: reps=9, iters/16\n"
+        "output: CSV on stdout (bench,sched,threads,pin,chunk,n,cost,reps,median_ns,p99_ns,per_iter_ns)\n",
+        prog);
+}
+
+static int want(const char *list, const char *name){
+    if (!list) return 1;
+    size_t len = strlen(name);
+    for (const char *p = list; *p; ) {
+        const char *e = strchr(p, ',');
+        size_t l = e ? (size_t)(e - p) : strlen(p);
+        if (l == len && strncmp(p, name, l) == 0) return 1;
+        if (!e) break;
+        p = e + 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv){
+    int reps = 31, maxthr = 0, quick = 0;
+    long n = 1L << 20, cost = 4;
+    const char *list = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:t:n:c:b:qh")) != -1) {
+        switch (opt) {
+        case 'r': reps = atoi(optarg); break;
+        case 't': maxthr = atoi(optarg); break;
+        case 'n': n = atol(optarg); break;
+        case 'c': cost = atol(optarg); break;
+        case 'b': list = optarg; break;
+        case 'q': quick = 1; break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (quick) { reps = 9; n /= 16; }
+    if (reps < 1 || n < 1 || cost < 0) { usage(argv[0]); return 1; }
+    if (maxthr <= 0) maxthr = parallel_default_threads();
+
+    Timer tm = { .reps = reps, .t = (long*)malloc(sizeof(long) * (size_t)reps) };
+    if (!tm.t) return 1;
+    // 일 있는 벤치는 반복 수를 줄여 한 번에 수 ms 가 되게
+    long wn = n / 16 > 0 ? n / 16 : 1;
+
+    printf("bench,sched,threads,pin,chunk,n,cost,reps,median_ns,p99_ns,per_iter_ns\n");
+    int rc = 0;
+    if (rc == 0 && want(list, "empty"))    rc = bench_empty(&tm, maxthr, 0);
+    if (rc == 0 && want(list, "dispatch")) rc = bench_dispatch(&tm, maxthr, 0, n);
+    if (rc == 0 && want(list, "scaling"))  rc = bench_work(&tm, "scaling", maxthr, 0, wn, cost, 0, 1);
+    if (rc == 0 && want(list, "pin")) {
+        rc = bench_work(&tm, "pin", maxthr, 0, wn, cost, 0, 0);
+        if (rc == 0) rc = bench_work(&tm, "pin", maxthr, 1, wn, cost, 0, 0);
+    }
+    if (rc == 0 && want(list, "skew"))     rc = bench_work(&tm, "skew", maxthr, 0, wn, cost, 1, 0);
+    free(tm.t);
+    if (rc != 0) fprintf(stderr, "bench failed\n");
+    return rc != 0;
+}
@@ -6,17 +6,276 @@ extern "C" {
 #endif
 
 typedef void (*pfor_body_fn)(long i, void *userdata);
+/* 청크 [start, stop) 를 통째로 받는 body: 루프 안쪽을 컴파일러가 인라인/벡터화할 수 있다 */
+typedef void (*pfor_range_fn)(long start, long stop, void *userdata);
 
 enum parallel_options
 {
     PARALLEL_OPT_PIN_CORE = 1 << 0,
-    PARALLEL_OPT_REALTIME = 1 << 1
+    PARALLEL_OPT_REALTIME = 1 << 1,
+
+    /* 스케줄링 모드 (하나만 선택) */
+    PARALLEL_OPT_SCHED_SHARED = 0 << 4,     // 공유 next counter (기본)
+    PARALLEL_OPT_SCHED_STEAL  = 1 << 4,     // 스레드별 range deque + 절반 stealing
+    PARALLEL_OPT_SCHED_GUIDED = 2 << 4,     // 남은 양 / (2*nthreads), chunk는 최소 크기
+    PARALLEL_OPT_SCHED_ADAPTIVE = 3 << 4,   // 측정한 반복당 시간으로 크기 결정, chunk 무시
+    PARALLEL_OPT_SCHED_STATIC = 4 << 4,     // 워커 t는 항상 t번째 연속 구간 (NUMA first-touch)
+    PARALLEL_OPT_SCHED_MASK   = 0xf << 4,
+
+    /* PIN_CORE 배치 정책 (하나만 선택, sysfs 토폴로지 기준) */
+    PARALLEL_OPT_PLACE_LINEAR   = 0 << 8,   // affinity 안의 CPU 번호 순 (기본)
+    PARALLEL_OPT_PLACE_COMPACT  = 1 << 8,   // 노드 → 코어 → SMT 형제 순으로 채움
+    PARALLEL_OPT_PLACE_SCATTER  = 2 << 8,   // 노드를 번갈아 물리 코어 먼저, SMT는 마지막
+    PARALLEL_OPT_PLACE_PHYSICAL = 3 << 8,   // 물리 코어당 하나 (SMT 형제 제외)
+    PARALLEL_OPT_PLACE_MASK     = 0xf << 8,
+
+    /* 워커별 통계를 기록 (parallel_last_stats). PARALLEL_STATS=1 환경 변수면 모든 루프 */
+    PARALLEL_OPT_STATS = 1 << 12,
+
+    /* parallel_scan: out[i] 에 in[i] 까지 포함 (기본은 exclusive) */
+    PARALLEL_OPT_SCAN_INCLUSIVE = 1 << 13,
+
+    /* STATS 에 더해 워커별 perf_event_open 카운터 (parallel_perf_counts).
+     * PARALLEL_STATS=perf 환경 변수면 모든 루프 */
+    PARALLEL_OPT_PERF = 1 << 14
 };
 
+/* body 안에서 부르면 nthreads / PIN_CORE / REALTIME 은 무시하고 지금 워커의 pool 에
+ * 중첩된다 (스레드 수가 곱으로 늘지 않는다). reduce 도 같다.
+ * 모든 반복이 돌았으면 0, body 가 parallel_cancel() 로 멈췄으면 1, 오류는 음수 */
 int parallel_for(long begin, long end, long chunk,
                  int nthreads, int options,
                  pfor_body_fn body, void *userdata);
 
+int parallel_for_range(long begin, long end, long chunk,
+                       int nthreads, int options,
+                       pfor_range_fn fn, void *userdata);
+
+/* 리덕션: 범위를 (end - begin, chunk, size) 로만 정해지는 연속 블록으로 나눈다 (chunk 이상,
+ * 많아야 PARALLEL_REDUCE_MAX_BLOCKS = 1024 개). acc 는 블록마다 캐시라인 정렬 슬롯 (identity 로
+ * 초기화), map 은 블록 범위를 acc 에 누적하고, 끝나면 슬롯들을 블록 순서대로
+ * combine(result, slot) 해서 result 에 쓴다. 결합 순서가 스레드 수와 스케줄에 상관없이 고정이라
+ * combine 은 결합법칙만 있으면 되고 (교환법칙은 불필요) 부동소수점 합도 매번 같다.
+ * 범위가 비면 result = identity. cancel 은 블록 경계에서 멈춘다: 1 을 돌려주고 result 는
+ * 돈 블록까지만 합친 값 */
+typedef void (*preduce_map_fn)(long start, long stop, void *acc, void *userdata);
+typedef void (*preduce_combine_fn)(void *acc, const void *other, void *userdata);
+
+int parallel_reduce(long begin, long end, long chunk,
+                    int nthreads, int options,
+                    const void *identity, size_t size,
+                    preduce_map_fn map, preduce_combine_fn combine,
+                    void *userdata, void *result);
+
+/* 검색: pred(i) 가 참인 가장 작은 i 를 *index 에 (없으면 end). 찾으면 뒤쪽 청크는
+ * 나눠주지 않고 이미 가져간 (더 앞일 수 있는) 청크만 끝낸다.
+ * 청크를 앞에서부터 나눠야 하므로 스케줄링 모드는 무시하고 shared. 성공 0, 인자 오류 -1 */
+typedef int (*pfind_pred_fn)(long i, void *userdata);
+
+int parallel_find_first(long begin, long end, long chunk,
+                        int nthreads, int options,
+                        pfind_pred_fn pred, void *userdata, long *index);
+
+/* 스캔 (prefix sum): out[i] = in[0] ⊕ … ⊕ in[i-1], out[0] = identity (exclusive).
+ * op 는 reduce 의 combine 과 같이 acc ⊕= other, 결합법칙만 있으면 된다 (교환법칙은 불필요).
+ * 원소는 size 바이트 간격, in == out (제자리) 가능. chunk 는 블록 크기 (원소 수), <= 0 이면
+ * 워커 수에 맞춰 자동. 블록 경계가 스케줄과 무관하게 고정이라 결과는 항상 같다.
+ * total 이 NULL 이 아니면 전체 합. 성공 0, 인자 오류 -1, 할당 실패 -2 */
+int parallel_scan(const void *in, void *out, long n, long chunk,
+                  int nthreads, int options,
+                  const void *identity, size_t size,
+                  preduce_combine_fn op, void *userdata, void *total);
+/* long 덧셈 (넘치면 2 의 보수로 감긴다), op 간접 호출 없음 */
+int parallel_scan_long(const long *in, long *out, long n, long chunk,
+                       int nthreads, int options, long *total);
+
+/* persistent pool: 워커는 job 사이에 잠들어 있다가 job마다 깨어난다.
+ * PIN_CORE / REALTIME 은 생성 시 워커마다 한 번만 적용된다. */
+typedef struct parallel_pool parallel_pool;
+
+/* 워커 스레드의 스케줄링. REALTIME 옵션 (SCHED_FIFO 최고 우선순위) 보다 세밀하게:
+ * 지연에 민감한 루프는 적당한 FIFO/RR 우선순위나 DEADLINE 예약으로, 배경 압축은 BATCH/IDLE
+ * 이나 양의 nice 로 두면 한 기계에서 서로 굶기지 않는다.
+ * FIFO/RR/DEADLINE 과 음의 nice 는 CAP_SYS_NICE 가 필요하다. 적용에 실패하면 경고 한 번 뒤에
+ * 원래 정책으로 돈다. DEADLINE 은 커널이 허용 조건을 검사하고 핀닝 (일부 CPU 만 허용) 과 같이
+ * 쓸 수 없다 */
+enum parallel_sched_policy
+{
+    PARALLEL_SCHED_INHERIT = 0,     // 만든 스레드의 것 그대로 (REALTIME 옵션이 있으면 그것)
+    PARALLEL_SCHED_NORMAL,          // SCHED_OTHER + nice
+    PARALLEL_SCHED_BATCH,           // SCHED_BATCH + nice: CPU 만 쓰는 배경 일
+    PARALLEL_SCHED_IDLE,            // SCHED_IDLE: 다른 일이 없을 때만
+    PARALLEL_SCHED_FIFO,            // SCHED_FIFO + priority
+    PARALLEL_SCHED_RR,              // SCHED_RR + priority
+    PARALLEL_SCHED_DEADLINE,        // SCHED_DEADLINE: period 마다 runtime 을 deadline 안에
+};
+
+typedef struct
+{
+    int policy;                     // enum parallel_sched_policy
+    int priority;                   // FIFO / RR: 1..99
+    int nice;                       // NORMAL / BATCH: -20..19
+    unsigned long runtime_ns;       // DEADLINE
+    unsigned long deadline_ns;      // DEADLINE, 0 이면 period
+    unsigned long period_ns;        // DEADLINE, 0 이면 deadline
+} parallel_sched;
+
+/* 워커별 상태 (코덱 컨텍스트, 스크래치 버퍼 등) 를 워커마다 한 번만 만든다 */
+typedef void *(*pworker_init_fn)(int thr_idx, void *arg);
+typedef void  (*pworker_fini_fn)(int thr_idx, void *local, void *arg);
+
+typedef struct
+{
+    int nthreads;               // <= 0 이면 parallel_default_threads()
+    int options;                // PIN_CORE / REALTIME
+    pworker_init_fn init;       // 워커 시작 시, 반환값은 parallel_worker_local()
+    pworker_fini_fn fini;       // 워커 종료 시
+    void *hook_arg;
+    /* 워커가 다음 job 을, 제출자가 job 완료를 기다릴 때 futex 로 잠들기 전에 pause 로
+     * 도는 시간. 0 이면 바로 잠든다 (CPU 를 가장 적게 씀, 기본). 짧은 루프를 연달아
+     * 부르면 job 간격보다 조금 길게 잡아 깨우는 비용을 없앤다. < 0 (PARALLEL_SPIN_FOREVER)
+     * 이면 잠들지 않는다: 코어를 전용으로 쓰는 REALTIME pool 에서 지연이 가장 짧다 */
+    long spin_ns;
+    /* 워커의 기본 스케줄링 (생성 시 한 번). 0 으로 두면 INHERIT */
+    parallel_sched sched;
+} parallel_pool_attr;
+
+#define PARALLEL_SPIN_FOREVER (-1L)
+
+void parallel_pool_attr_init(parallel_pool_attr *attr);
+parallel_pool *parallel_pool_create_attr(const parallel_pool_attr *attr);
+parallel_pool *parallel_pool_create(int nthreads, int options);
+int parallel_pool_size(const parallel_pool *pool);
+
+/* nthreads <= 0 일 때의 스레드 수: affinity 안의 CPU 수와 cgroup CPU 할당량
+ * (v2 cpu.max, v1 cpu.cfs_quota_us / cfs_period_us 를 올림, 조상 cgroup 포함) 중 작은 값.
+ * 할당량은 처음 한 번 읽는다. PIN_CORE 는 배치 순서의 CPU 수로도 제한된다 (PLACE_PHYSICAL) */
+int parallel_default_threads(void);
+
+/* 반환값은 parallel_for 와 같다. 자기 pool 워커 안에서 부르면 중첩되어
+ * 새 job 으로 큐에 오르고, 호출한 워커는 기다리는 동안 그 job 을 돕는다 */
+int parallel_pool_for(parallel_pool *pool,
+                      long begin, long end, long chunk, int options,
+                      pfor_body_fn body, void *userdata);
+int parallel_pool_for_range(parallel_pool *pool,
+                            long begin, long end, long chunk, int options,
+                            pfor_range_fn fn, void *userdata);
+/* 이 호출 동안만 워커를 sched 로 돌린다 (워커는 job 을 잡을 때 바꾸고, 일이 없어지면
+ * pool 기본으로 되돌린다). 돕는 호출 스레드와 중첩 job 을 돕는 워커는 자기 정책 그대로.
+ * sched 가 잘못됐으면 -1, 나머지는 parallel_pool_for_range 와 같다 */
+int parallel_pool_for_range_sched(parallel_pool *pool,
+                                  long begin, long end, long chunk, int options,
+                                  const parallel_sched *sched,
+                                  pfor_range_fn fn, void *userdata);
+int parallel_pool_reduce(parallel_pool *pool,
+                         long begin, long end, long chunk, int options,
+                         const void *identity, size_t size,
+                         preduce_map_fn map, preduce_combine_fn combine,
+                         void *userdata, void *result);
+int parallel_pool_find_first(parallel_pool *pool,
+                             long begin, long end, long chunk, int options,
+                             pfind_pred_fn pred, void *userdata, long *index);
+int parallel_pool_scan(parallel_pool *pool,
+                       const void *in, void *out, long n, long chunk, int options,
+                       const void *identity, size_t size,
+                       preduce_combine_fn op, void *userdata, void *total);
+int parallel_pool_scan_long(parallel_pool *pool,
+                            const long *in, long *out, long n, long chunk, int options,
+                            long *total);
+void parallel_pool_destroy(parallel_pool *pool);
+
+/* 태스크 그룹: spawn 한 태스크를 pool 워커들이 실행하고 wait 가 전부 끝나기를 기다린다.
+ * 워커 안에서 wait 하면 잠들지 않고 그룹의 (그리고 더 안쪽 중첩 job 의) 일을 돕는다.
+ * 태스크는 pool->lock 한 번에 하나씩 꺼내므로 청크보다 굵은 일 (타일, 재귀 분할) 에 맞다. */
+typedef struct parallel_task_group parallel_task_group;
+typedef void (*ptask_fn)(void *arg);
+
+/* pool 이 NULL 이면 현재 워커의 pool. 실패 시 NULL */
+parallel_task_group *parallel_task_group_create(parallel_pool *pool);
+/* 성공 0, 인자 오류 -1, 할당 실패 -2. 태스크 안에서 같은 그룹에 spawn 해도 된다 */
+int  parallel_task_spawn(parallel_task_group *group, ptask_fn fn, void *arg);
+int  parallel_task_group_wait(parallel_task_group *group);
+/* 남은 태스크를 기다린 뒤 해제 */
+void parallel_task_group_destroy(parallel_task_group *group);
+
+/* 비동기 루프: job 을 큐에 올리고 바로 돌아온다. userdata 는 wait 가 끝날 때까지 살아 있어야 한다.
+ * pool 없는 판은 future 가 일회성 pool 을 들고 있다가 destroy 때 스레드를 조인한다
+ * (body 안에서 부르면 위와 같이 지금 워커의 pool 에 중첩). 인자 오류나 실패 시 NULL */
+typedef struct parallel_future parallel_future;
+
+parallel_future *parallel_for_async(long begin, long end, long chunk,
+                                    int nthreads, int options,
+                                    pfor_body_fn body, void *userdata);
+parallel_future *parallel_for_range_async(long begin, long end, long chunk,
+                                          int nthreads, int options,
+                                          pfor_range_fn fn, void *userdata);
+parallel_future *parallel_pool_for_async(parallel_pool *pool,
+                                         long begin, long end, long chunk, int options,
+                                         pfor_body_fn body, void *userdata);
+parallel_future *parallel_pool_for_range_async(parallel_pool *pool,
+                                               long begin, long end, long chunk, int options,
+                                               pfor_range_fn fn, void *userdata);
+
+/* 끝났으면 1, 아직이면 0. 기다리지 않는다 */
+int  parallel_future_test(parallel_future *f);
+/* 끝날 때까지 기다린다. help 면 호출 스레드도 pool 의 여분 슬롯 (워커 번호 = pool 크기)
+ * 으로 청크를 가져간다: 그 슬롯의 init 훅은 처음 도울 때 호출 스레드에서 불린다.
+ * 같은 pool 워커 안에서는 help 와 상관없이 돕는다.
+ * 모든 반복이 돌았으면 0, cancel 로 건너뛴 청크가 있으면 1 */
+int  parallel_future_wait(parallel_future *f, int help);
+/* 아직 나눠주지 않은 청크를 버린다. 실행 중인 청크는 끝까지 돈다. 기다리지 않는다 */
+int  parallel_future_cancel(parallel_future *f);
+/* 돕지 않고 끝나기를 기다린 뒤 해제 */
+void parallel_future_destroy(parallel_future *f);
+
+/* body 안에서 호출: 현재 워커 번호 [0, count), 워커 밖이면 -1 / 0 / NULL.
+ * count 는 pool 크기 + 1 (future wait 로 합류한 호출자 슬롯 포함) */
+int   parallel_worker_index(void);
+int   parallel_worker_count(void);
+void *parallel_worker_local(void);
+
+/* PARALLEL_OPT_PERF: 루프에 참여한 동안의 카운터 증분. 커널 포함 (권한이 없으면 사용자만),
+ * 다중화되면 돈 시간 비율로 보정.
+ * 열지 못한 카운터 (가상 머신의 PMU 없음, perf_event_paranoid 등) 나 재지 않은 값은 -1 */
+typedef struct
+{
+    long cycles;
+    long instructions;
+    long llc_misses;        // PERF_COUNT_HW_CACHE_MISSES (보통 마지막 단계 캐시)
+    long branch_misses;
+    long context_switches;
+} parallel_perf_counts;
+
+/* PARALLEL_OPT_STATS 로 켠 루프의 워커별 통계. 시각은 CLOCK_MONOTONIC ns, 제출 기준 */
+typedef struct
+{
+    long chunks;            // 가져간 청크 수
+    long iterations;        // 실행한 반복 수
+    long busy_ns;           // body 안에 있던 시간
+    long idle_ns;           // wall_ns - busy_ns: 청크 분배, stealing, 대기, 늦은 합류
+    long first_start_ns;    // 첫 청크 시작, 청크를 못 받았으면 -1
+    long last_finish_ns;    // 마지막 청크 끝, 없으면 -1
+    int  cpu;               // 마지막 청크를 돈 CPU, 없으면 -1
+    int  migrations;        // 청크 사이에 CPU 가 바뀐 횟수
+    parallel_perf_counts perf;
+} parallel_worker_stats;
+
+typedef struct
+{
+    long wall_ns;           // 제출부터 마지막 워커가 빠질 때까지
+    int  nworkers;          // pool 크기 + 1 (마지막은 future wait 로 합류한 호출자 슬롯)
+    const parallel_worker_stats *workers;   // 이 스레드의 다음 통계 루프 전까지 유효
+    parallel_perf_counts perf;              // 워커 합, 어느 워커도 못 잰 카운터는 -1
+} parallel_stats;
+
+/* 이 스레드가 마지막으로 돌린 (future 는 wait 한) 통계 루프. 성공 0, 없으면 -1.
+ * 태스크 그룹은 기록하지 않는다 */
+int parallel_last_stats(parallel_stats *out);
+
+/* body 안에서 호출: 지금 돌고 있는 루프의 남은 청크를 버린다. 모든 워커가 다음 청크
+ * 경계에서 멈추고, 중첩 루프면 가장 안쪽 루프만. 성공 0, 루프 body 밖 (태스크 포함) 이면 -1 */
+int   parallel_cancel(void);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
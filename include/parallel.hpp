@@ -0,0 +1,315 @@
+#pragma once
+// C++ front-end: 호출 객체 타입마다 청크 루프를 인스턴스화해서
+// 인덱스마다의 간접 호출 없이 parallel_for_range 스케줄러를 그대로 쓴다.
+#include "parallel.h"
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace parallel
+{
+
+namespace detail
+{
+    // 청크 하나에 간접 호출 한 번, 안쪽 루프는 f 가 인라인된다.
+    // 예외는 C 프레임을 넘어갈 수 없으므로 noexcept (던지면 std::terminate)
+    template <class F>
+    void index_thunk(long start, long stop, void *userdata) noexcept
+    {
+        F &f = *static_cast<F *>(userdata);
+        for (long i = start; i < stop; ++i) f(i);
+    }
+
+    template <class F>
+    void range_thunk(long start, long stop, void *userdata) noexcept
+    {
+        F &f = *static_cast<F *>(userdata);
+        f(start, stop);
+    }
+
+    template <class Map, class Combine>
+    struct reducer
+    {
+        Map &map;
+        Combine &combine;
+    };
+
+    template <class R, class T>
+    void reduce_map_thunk(long start, long stop, void *acc, void *userdata) noexcept
+    {
+        R &r = *static_cast<R *>(userdata);
+        T &a = *static_cast<T *>(acc);
+        for (long i = start; i < stop; ++i) r.map(a, i);
+    }
+
+    template <class R, class T>
+    void reduce_combine_thunk(void *acc, const void *other, void *userdata) noexcept
+    {
+        R &r = *static_cast<R *>(userdata);
+        r.combine(*static_cast<T *>(acc), *static_cast<const T *>(other));
+    }
+
+    template <class Op, class T>
+    void scan_op_thunk(void *acc, const void *other, void *userdata) noexcept
+    {
+        Op &op = *static_cast<Op *>(userdata);
+        op(*static_cast<T *>(acc), *static_cast<const T *>(other));
+    }
+
+    template <class P>
+    int find_thunk(long i, void *userdata) noexcept
+    {
+        P &p = *static_cast<P *>(userdata);
+        return p(i) ? 1 : 0;
+    }
+
+    template <class F>
+    void *erase(F &f) noexcept
+    {
+        return const_cast<void *>(static_cast<const void *>(&f));
+    }
+} // namespace detail
+
+struct options
+{
+    long chunk    = 1;
+    int  nthreads = 0;      // <= 0 이면 parallel_default_threads()
+    int  flags    = 0;      // enum parallel_options 조합
+};
+
+/* parallel_pool RAII 래퍼 (move-only) */
+class pool
+{
+public:
+    explicit pool(int nthreads = 0, int flags = 0)
+        : p_(parallel_pool_create(nthreads, flags)) {}
+    explicit pool(const parallel_pool_attr &attr)
+        : p_(parallel_pool_create_attr(&attr)) {}
+    ~pool() { parallel_pool_destroy(p_); }
+
+    pool(const pool &) = delete;
+    pool &operator=(const pool &) = delete;
+    pool(pool &&o) noexcept : p_(o.p_) { o.p_ = nullptr; }
+    pool &operator=(pool &&o) noexcept
+    {
+        if (this != &o) { parallel_pool_destroy(p_); p_ = o.p_; o.p_ = nullptr; }
+        return *this;
+    }
+
+    explicit operator bool() const noexcept { return p_ != nullptr; }
+    int size() const noexcept { return parallel_pool_size(p_); }
+    parallel_pool *native() const noexcept { return p_; }
+
+private:
+    parallel_pool *p_;
+};
+
+/* 태스크 그룹 RAII 래퍼: 소멸자가 남은 태스크를 기다린다.
+ * spawn 한 호출 객체는 복사/이동해서 힙에 두고 실행 후 지운다. */
+class task_group
+{
+public:
+    explicit task_group(pool &p) : g_(parallel_task_group_create(p.native())) {}
+    task_group() : g_(parallel_task_group_create(nullptr)) {}     // body 안: 현재 워커의 pool
+    ~task_group() { parallel_task_group_destroy(g_); }
+
+    task_group(const task_group &) = delete;
+    task_group &operator=(const task_group &) = delete;
+
+    explicit operator bool() const noexcept { return g_ != nullptr; }
+
+    template <class F>
+    int spawn(F &&f)
+    {
+        using Fn = std::decay_t<F>;
+        Fn *heap = new Fn(std::forward<F>(f));
+        int rc = parallel_task_spawn(g_, &task_thunk<Fn>, heap);
+        if (rc != 0) delete heap;
+        return rc;
+    }
+
+    int wait() { return parallel_task_group_wait(g_); }
+    parallel_task_group *native() const noexcept { return g_; }
+
+private:
+    template <class Fn>
+    static void task_thunk(void *arg) noexcept
+    {
+        Fn *f = static_cast<Fn *>(arg);
+        (*f)();
+        delete f;
+    }
+
+    parallel_task_group *g_;
+};
+
+/* 비동기 루프 핸들 (move-only): 호출 객체를 힙에 들고 있다가 소멸자에서 끝나기를 기다린다 */
+template <class F>
+class future
+{
+public:
+    // for_each_async / for_range_async 가 만든다. p 가 nullptr 이면 일회성 pool
+    future(F f, parallel_pool *p, long begin, long end, const options &o, pfor_range_fn thunk)
+        : f_(new F(std::move(f)))
+    {
+        h_ = p ? parallel_pool_for_range_async(p, begin, end, o.chunk, o.flags, thunk, f_.get())
+               : parallel_for_range_async(begin, end, o.chunk, o.nthreads, o.flags, thunk, f_.get());
+    }
+    ~future() { parallel_future_destroy(h_); }
+
+    future(const future &) = delete;
+    future &operator=(const future &) = delete;
+    future(future &&o) noexcept : f_(std::move(o.f_)), h_(o.h_) { o.h_ = nullptr; }
+    future &operator=(future &&o) noexcept
+    {
+        if (this != &o) { parallel_future_destroy(h_); f_ = std::move(o.f_); h_ = o.h_; o.h_ = nullptr; }
+        return *this;
+    }
+
+    explicit operator bool() const noexcept { return h_ != nullptr; }
+    bool test() const noexcept { return parallel_future_test(h_) == 1; }
+    int wait(bool help = true) { return parallel_future_wait(h_, help); }
+    int cancel() { return parallel_future_cancel(h_); }
+    parallel_future *native() const noexcept { return h_; }
+
+private:
+    std::unique_ptr<F> f_;
+    parallel_future *h_ = nullptr;
+};
+
+template <class F>
+future<std::decay_t<F>> for_each_async(long begin, long end, F &&f, const options &o = options())
+{
+    using Fn = std::decay_t<F>;
+    return future<Fn>(Fn(std::forward<F>(f)), nullptr, begin, end, o, &detail::index_thunk<Fn>);
+}
+
+template <class F>
+future<std::decay_t<F>> for_each_async(pool &p, long begin, long end, F &&f, const options &o = options())
+{
+    using Fn = std::decay_t<F>;
+    return future<Fn>(Fn(std::forward<F>(f)), p.native(), begin, end, o, &detail::index_thunk<Fn>);
+}
+
+template <class F>
+future<std::decay_t<F>> for_range_async(long begin, long end, F &&f, const options &o = options())
+{
+    using Fn = std::decay_t<F>;
+    return future<Fn>(Fn(std::forward<F>(f)), nullptr, begin, end, o, &detail::range_thunk<Fn>);
+}
+
+template <class F>
+future<std::decay_t<F>> for_range_async(pool &p, long begin, long end, F &&f, const options &o = options())
+{
+    using Fn = std::decay_t<F>;
+    return future<Fn>(Fn(std::forward<F>(f)), p.native(), begin, end, o, &detail::range_thunk<Fn>);
+}
+
+/* f(i) for i in [begin, end) */
+template <class F>
+int for_each(long begin, long end, F &&f, const options &o = options())
+{
+    using Fn = std::remove_reference_t<F>;
+    return parallel_for_range(begin, end, o.chunk, o.nthreads, o.flags,
+                              &detail::index_thunk<Fn>, detail::erase(f));
+}
+
+template <class F>
+int for_each(pool &p, long begin, long end, F &&f, const options &o = options())
+{
+    using Fn = std::remove_reference_t<F>;
+    return parallel_pool_for_range(p.native(), begin, end, o.chunk, o.flags,
+                                   &detail::index_thunk<Fn>, detail::erase(f));
+}
+
+/* f(start, stop) 청크 단위 */
+template <class F>
+int for_range(long begin, long end, F &&f, const options &o = options())
+{
+    using Fn = std::remove_reference_t<F>;
+    return parallel_for_range(begin, end, o.chunk, o.nthreads, o.flags,
+                              &detail::range_thunk<Fn>, detail::erase(f));
+}
+
+template <class F>
+int for_range(pool &p, long begin, long end, F &&f, const options &o = options())
+{
+    using Fn = std::remove_reference_t<F>;
+    return parallel_pool_for_range(p.native(), begin, end, o.chunk, o.flags,
+                                   &detail::range_thunk<Fn>, detail::erase(f));
+}
+
+/* pred(i) 가 참인 가장 작은 i 를 index 에 (없으면 end) */
+template <class P>
+int find_first(long begin, long end, P &&pred, long &index, const options &o = options())
+{
+    using Pn = std::remove_reference_t<P>;
+    return parallel_find_first(begin, end, o.chunk, o.nthreads, o.flags,
+                               &detail::find_thunk<Pn>, detail::erase(pred), &index);
+}
+
+template <class P>
+int find_first(pool &p, long begin, long end, P &&pred, long &index, const options &o = options())
+{
+    using Pn = std::remove_reference_t<P>;
+    return parallel_pool_find_first(p.native(), begin, end, o.chunk, o.flags,
+                                    &detail::find_thunk<Pn>, detail::erase(pred), &index);
+}
+
+/* body 안에서: 지금 루프의 남은 청크를 버린다 */
+inline int cancel() noexcept { return parallel_cancel(); }
+
+/* map(acc, i) 로 블록별 acc 에 누적, combine(acc, other) 로 블록 순서대로 합친다 (parallel_reduce).
+ * T 는 슬롯에 memcpy 되므로 trivially copyable 이어야 한다. */
+template <class T, class Map, class Combine>
+int reduce(long begin, long end, const T &identity, Map &&map, Combine &&combine,
+           T &result, const options &o = options())
+{
+    static_assert(std::is_trivially_copyable<T>::value, "reduce: T must be trivially copyable");
+    using Mn = std::remove_reference_t<Map>;
+    using Cn = std::remove_reference_t<Combine>;
+    using R  = detail::reducer<Mn, Cn>;
+    R r{map, combine};
+    return parallel_reduce(begin, end, o.chunk, o.nthreads, o.flags, &identity, sizeof(T),
+                           &detail::reduce_map_thunk<R, T>, &detail::reduce_combine_thunk<R, T>,
+                           &r, &result);
+}
+
+template <class T, class Map, class Combine>
+int reduce(pool &p, long begin, long end, const T &identity, Map &&map, Combine &&combine,
+           T &result, const options &o = options())
+{
+    static_assert(std::is_trivially_copyable<T>::value, "reduce: T must be trivially copyable");
+    using Mn = std::remove_reference_t<Map>;
+    using Cn = std::remove_reference_t<Combine>;
+    using R  = detail::reducer<Mn, Cn>;
+    R r{map, combine};
+    return parallel_pool_reduce(p.native(), begin, end, o.chunk, o.flags, &identity, sizeof(T),
+                                &detail::reduce_map_thunk<R, T>, &detail::reduce_combine_thunk<R, T>,
+                                &r, &result);
+}
+
+/* op(acc, x) 로 acc ⊕= x 인 exclusive 스캔 (o.flags 에 PARALLEL_OPT_SCAN_INCLUSIVE 면 inclusive).
+ * o.chunk 는 블록 크기, 기본값 1 이면 자동. in == out 가능 */
+template <class T, class Op>
+int scan(const T *in, T *out, long n, const T &identity, Op &&op,
+         T *total = nullptr, const options &o = options())
+{
+    static_assert(std::is_trivially_copyable<T>::value, "scan: T must be trivially copyable");
+    using On = std::remove_reference_t<Op>;
+    return parallel_scan(in, out, n, o.chunk > 1 ? o.chunk : 0, o.nthreads, o.flags, &identity, sizeof(T),
+                         &detail::scan_op_thunk<On, T>, detail::erase(op), total);
+}
+
+template <class T, class Op>
+int scan(pool &p, const T *in, T *out, long n, const T &identity, Op &&op,
+         T *total = nullptr, const options &o = options())
+{
+    static_assert(std::is_trivially_copyable<T>::value, "scan: T must be trivially copyable");
+    using On = std::remove_reference_t<Op>;
+    return parallel_pool_scan(p.native(), in, out, n, o.chunk > 1 ? o.chunk : 0, o.flags, &identity, sizeof(T),
+                              &detail::scan_op_thunk<On, T>, detail::erase(op), total);
+}
+
+} // namespace parallel
@@ -0,0 +1,59 @@
+#pragma once
+/* 배열 일괄 연산: 배열을 캐시라인 정렬 타일로 나눠 pool 워커에 나누고, 타일 안쪽은
+ * 처음 부를 때 CPU 에 맞춰 고른 SIMD 루프 (AVX-512 / AVX2 / NEON / 스칼라) 로 돈다.
+ *
+ * pool 이 NULL 이면 body 안에서는 지금 워커의 pool 에 중첩, 밖에서는 parallel_default_threads() 개의
+ * 일회성 pool. options 는 스케줄링 / 배치 (PARALLEL_OPT_*) 이고 청크 단위는 타일 하나.
+ * 반환값은 parallel_for 와 같다 (n == 0 이면 0). dst 와 src 는 같거나 (제자리) 겹치지 않아야 한다. */
+#include "parallel.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 타일 하나 = dst 기준 이만한 바이트 (첫 타일은 dst 를 64B 에 맞추는 머리 부분) */
+#ifndef PARALLEL_ARRAY_TILE_BYTES
+#  define PARALLEL_ARRAY_TILE_BYTES (64 << 10)
+#endif
+
+/* 이보다 큰 fill / copy 는 non-temporal store 로 캐시를 거치지 않는다 (x86 AVX2 이상) */
+#ifndef PARALLEL_ARRAY_NT_BYTES
+#  define PARALLEL_ARRAY_NT_BYTES (32L << 20)
+#endif
+
+/* 사용자 커널: 타일 하나 [0, n) 를 통째로 받는다. 포인터는 타일 시작 (dst 는 64B 정렬) */
+typedef void (*ptransform_f32_fn)(float *dst, const float *src, size_t n, void *userdata);
+typedef void (*ptransform_f64_fn)(double *dst, const double *src, size_t n, void *userdata);
+typedef void (*ptransform_u8_fn)(unsigned char *dst, const unsigned char *src, size_t n, void *userdata);
+
+int parallel_transform_f32(parallel_pool *pool, float *dst, const float *src, size_t n,
+                           ptransform_f32_fn fn, void *userdata, int options);
+int parallel_transform_f64(parallel_pool *pool, double *dst, const double *src, size_t n,
+                           ptransform_f64_fn fn, void *userdata, int options);
+int parallel_transform_u8(parallel_pool *pool, unsigned char *dst, const unsigned char *src, size_t n,
+                          ptransform_u8_fn fn, void *userdata, int options);
+
+/* 내장 SIMD 커널 */
+/* dst[i] = a * src[i] + b. SIMD 경로는 FMA 로 한 번만 반올림한다 (스칼라와 1ulp 차이 가능) */
+int parallel_affine_f32(parallel_pool *pool, float *dst, const float *src, size_t n,
+                        float a, float b, int options);
+int parallel_affine_f64(parallel_pool *pool, double *dst, const double *src, size_t n,
+                        double a, double b, int options);
+/* dst[i] = lut[src[i]] */
+int parallel_lut_u8(parallel_pool *pool, unsigned char *dst, const unsigned char *src, size_t n,
+                    const unsigned char lut[256], int options);
+
+/* dst 의 n 개 원소를 value (elem_size 바이트) 로 */
+int parallel_fill(parallel_pool *pool, void *dst, const void *value, size_t elem_size, size_t n,
+                  int options);
+/* memcpy 와 같다 (겹치면 안 된다) */
+int parallel_copy(parallel_pool *pool, void *dst, const void *src, size_t bytes, int options);
+
+/* 고른 커널 이름: "avx512", "avx2", "neon", "scalar".
+ * PARALLEL_ISA 환경 변수로 더 낮은 단계를 강제할 수 있다 (비교 / 검증용) */
+const char *parallel_array_isa(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+/* 파이프라인: item 0, 1, 2 … 이 단계 0 → 1 → … 을 차례로 지난다. item i 의 단계 s 는
+ * 단계 s-1 이 끝나는 대로 (SERIAL 단계면 i-1 의 단계 s 도 끝난 뒤) pool 의 태스크로 돈다.
+ * 단계 사이에 장벽이 없어서 전체가 가장 느린 단계의 속도로 흐른다.
+ *
+ * 배압: 동시에 떠 있는 item 은 window 개 (가장 오래된 미완료 item 부터 window 칸) 까지.
+ * 단계마다 입력 큐 한도를 주면 (앞 단계를 돌고 있는 것 포함) 그 큐가 찰 때 앞 단계가 새 item 을
+ * 시작하지 않는다. 가장 오래된 item 은 한도와 상관없이 진행하므로 데드락이 없다.
+ * 여러 item 이 기다리면 번호가 작은 것부터.
+ *
+ * 단계 함수가 0 이 아니면 파이프라인을 멈춘다: 새로 시작하는 일은 없고, 돌던 태스크만 끝낸다.
+ * 단, 첫 단계가 PARALLEL_PIPELINE_STOP 을 돌려주면 오류가 아니라 입력 끝 (그 item 부터 버린다) */
+#include "parallel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PARALLEL_PIPELINE_STOP 1
+
+enum parallel_stage_flags
+{
+    PARALLEL_STAGE_PARALLEL = 0,        // 여러 item 을 동시에, 순서 없이
+    PARALLEL_STAGE_SERIAL   = 1 << 0,   // 한 번에 하나, item 번호 순서대로 (읽기, 쓰기)
+};
+
+typedef struct parallel_pipeline parallel_pipeline;
+
+/* item 하나의 한 단계. 워커 스레드에서 돈다 (parallel_worker_local 사용 가능) */
+typedef int (*ppipe_stage_fn)(long item, void *userdata);
+
+/* pool 이 NULL 이면 현재 워커의 pool. window <= 0 이면 워커 수 x 4. 실패 시 NULL */
+parallel_pipeline *parallel_pipeline_create(parallel_pool *pool, long window);
+
+/* 단계를 뒤에 붙인다. queue 는 이 단계의 입력 큐 한도 (<= 0 이면 window 만).
+ * 성공 시 단계 번호, 인자 오류 -1, 할당 실패 -2 */
+int parallel_pipeline_add_stage(parallel_pipeline *pp, ppipe_stage_fn fn, void *userdata,
+                                int flags, long queue);
+
+/* item [0, nitems) 를 흘려 보내고 모두 끝나기를 기다린다. nitems < 0 이면 첫 단계가
+ * STOP 을 돌려줄 때까지. 다시 불러도 된다 (item 번호는 0 부터).
+ * 성공 0, 단계가 돌려준 첫 오류 값, 인자 오류 -1, 태스크 할당 실패 -2 */
+int parallel_pipeline_run(parallel_pipeline *pp, long nitems);
+
+/* 다 흘려 보낸 item 수 (마지막 run 에서 마지막 단계까지 끝난 것) */
+long parallel_pipeline_completed(const parallel_pipeline *pp);
+
+void parallel_pipeline_destroy(parallel_pipeline *pp);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+/* 병렬 정렬: 모두 안정 (같은 키는 원래 순서).
+ * - parallel_sort: 비교 함수로 병합 정렬. 블록을 워커마다 정렬한 뒤, 짝지은 두 run 의 병합을
+ *   merge path 로 잘라서 병합 단계마다 워커 수만큼의 일로 나눈다
+ * - parallel_sort_u32 / u64 / i32 / i64: LSD radix (8 비트씩). 블록별 히스토그램 →
+ *   parallel_scan 으로 자리 → 흩뿌리기. 모든 키가 같은 자리 값이면 그 자리는 건너뛴다
+ *
+ * scratch 는 parallel_sort_scratch_size(n, size) 바이트 (64B 정렬 권장). NULL 이면 안에서
+ * 할당한다. 결과는 항상 base 에 있다.
+ * pool 이 NULL 이면 body 안에서는 지금 워커의 pool 에 중첩, 밖에서는 parallel_default_threads() 개의 pool 을
+ * 정렬 한 번 동안 만든다. options 는 PARALLEL_OPT_* (스케줄링 / 배치).
+ * 할당 없이 돌려면 scratch 와 pool 을 넘긴다 (또는 워커 body 안에서 부른다). 그래도 SCHED_STEAL /
+ * SCHED_STATIC 은 루프마다 워커별 구간 배열을 할당하므로 다른 스케줄러를 쓴다.
+ * 성공 0, 인자 오류 -1, 할당 실패 -2, 스레드 생성 실패 -3 */
+#include "parallel.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 이보다 짧으면 호출 스레드에서 혼자 정렬한다 */
+#ifndef PARALLEL_SORT_SERIAL_CUTOFF
+#  define PARALLEL_SORT_SERIAL_CUTOFF 8192
+#endif
+
+/* qsort_r 과 같은 부호 규칙 */
+typedef int (*psort_cmp_fn)(const void *a, const void *b, void *userdata);
+
+size_t parallel_sort_scratch_size(size_t n, size_t size);
+
+int parallel_sort(parallel_pool *pool, void *base, size_t n, size_t size,
+                  psort_cmp_fn cmp, void *userdata, void *scratch, int options);
+
+int parallel_sort_u32(parallel_pool *pool, uint32_t *keys, size_t n, void *scratch, int options);
+int parallel_sort_u64(parallel_pool *pool, uint64_t *keys, size_t n, void *scratch, int options);
+int parallel_sort_i32(parallel_pool *pool, int32_t *keys, size_t n, void *scratch, int options);
+int parallel_sort_i64(parallel_pool *pool, int64_t *keys, size_t n, void *scratch, int options);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,1335 @@
+// pbz.c — 블록 병렬 압축기 (bzip2 호환 CLI, 코덱은 src/codec.c)
+// SPDX-License-Identifier: MIT
+#define _GNU_SOURCE
+#include "include/parallel.h"
+#include "src/codec.h"
+#include "src/writer.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+// 타이머
+static inline double sec_now(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+// 파일 읽기
+static unsigned char *read_file(const char *path, size_t *len_out){
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror("fopen"); return NULL; }
+    fseek(f, 0, SEEK_END); long sz = ftell(f);
+    if (sz < 0) { perror("ftell"); fclose(f); return NULL; }
+    fseek(f, 0, SEEK_SET);
+    unsigned char *buf = (unsigned char*)malloc((size_t)sz);
+    if (!buf) { fclose(f); return NULL; }
+    if (fread(buf, 1, (size_t)sz, f) != (size_t)sz) { perror("fread"); free(buf); fclose(f); return NULL; }
+    fclose(f);
+    *len_out = (size_t)sz;
+    return buf;
+}
+
+// 파일 mmap (zero-copy): 블록 입력이 페이지 캐시를 그대로 가리킨다
+static unsigned char *map_file(const char *path, size_t *len_out){
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { perror("open"); return NULL; }
+    struct stat st;
+    if (fstat(fd, &st) != 0) { perror("fstat"); close(fd); return NULL; }
+    if (st.st_size == 0) { close(fd); return read_file(path, len_out); }   // 빈 파일은 mmap 불가
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) { perror("mmap"); return NULL; }
+    madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+    *len_out = (size_t)st.st_size;
+    return (unsigned char*)p;
+}
+
+static void release_input(unsigned char *in, size_t len, int mapped){
+    if (mapped && len > 0) munmap(in, len);
+    else free(in);
+}
+
+// 곧 읽을 블록 범위를 미리 읽어 두도록 커널에 알린다 (페이지 정렬 필요)
+static void prefetch_range(const unsigned char *p, size_t len){
+    static long page = 0;
+    if (!page) page = sysconf(_SC_PAGESIZE);
+    uintptr_t lo = (uintptr_t)p & ~(uintptr_t)(page - 1);
+    madvise((void*)lo, (uintptr_t)p + len - lo, MADV_WILLNEED);
+}
+
+// 블록 메타
+typedef struct {
+    const unsigned char *in;
+    unsigned int in_len;
+    unsigned char *out;         // 압축 출력 버퍼
+    unsigned int out_cap;       // 할당 크기
+    unsigned int out_len;       // 실제 압축된 길이
+    int ok;                     // 0=fail, 1=success
+} Block;
+
+// ---- 순서대로 내보내기: 앞쪽 블록부터 끝나는 대로 writer 로 넘겨 쓰기를 압축과 겹친다 ----
+typedef struct {
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+    const Block *blocks;
+    size_t nb;
+    unsigned char *done;    // 블록별 완료 표시
+    int abort;              // 압축이 중간에 끝났다: 더 기다리지 않는다
+    writer *w;
+    int rc;
+} OrderedSink;
+
+static void sink_done(OrderedSink *k, long bi){
+    pthread_mutex_lock(&k->mu);
+    k->done[bi] = 1;
+    pthread_cond_signal(&k->cv);
+    pthread_mutex_unlock(&k->mu);
+}
+
+static void sink_abort(OrderedSink *k){
+    pthread_mutex_lock(&k->mu);
+    k->abort = 1;
+    pthread_cond_signal(&k->cv);
+    pthread_mutex_unlock(&k->mu);
+}
+
+static void *sink_main(void *arg){
+    OrderedSink *k = (OrderedSink*)arg;
+    for (size_t i=0;i<k->nb;++i){
+        pthread_mutex_lock(&k->mu);
+        while (!k->done[i] && !k->abort) pthread_cond_wait(&k->cv, &k->mu);
+        int ready = k->done[i];
+        pthread_mutex_unlock(&k->mu);
+        const Block *b = &k->blocks[i];
+        if (!ready || !b->ok || writer_append(k->w, b->out, b->out_len) != 0) { k->rc = -1; break; }
+    }
+    if (writer_close(k->w) != 0) k->rc = -1;
+    return NULL;
+}
+
+// ---- 자리 잡아 쓰기: 블록 i 의 파일 오프셋은 앞 블록 길이의 누적합이라, 0..i-1 이 다 끝나면
+// 정해진다. 앞줄 (frontier) 을 민 워커가 새로 자리가 정해진 블록들을 그 오프셋에 직접 pwrite 한다.
+// 쓰기가 여러 워커에 흩어지고 압축과도 겹친다 (직렬로 쓰는 sink 스레드가 없다) ----
+#define PLACED_IOV 64
+
+typedef struct {
+    pthread_mutex_t mu;
+    const Block *blocks;
+    size_t nb;
+    unsigned char *done;
+    size_t frontier;        // 오프셋이 아직 없는 첫 블록
+    uint64_t next_off;      // frontier 블록이 들어갈 오프셋
+    writer *w;
+    int rc;                 // 쓰기 실패 (atomic)
+} PlacedSink;
+
+static void placed_done(PlacedSink *k, long bi){
+    pthread_mutex_lock(&k->mu);
+    k->done[bi] = 1;
+    size_t lo = k->frontier, hi = lo;
+    uint64_t off = k->next_off;
+    if ((size_t)bi == lo){
+        while (hi < k->nb && k->done[hi]) k->next_off += k->blocks[hi++].out_len;
+        k->frontier = hi;
+    }
+    pthread_mutex_unlock(&k->mu);
+
+    // [lo, hi) 는 파일에서 이어져 있다: iovec 묶음으로
+    struct iovec iov[PLACED_IOV];
+    while (lo < hi){
+        int n = 0;
+        size_t len = 0;
+        for (; lo < hi && n < PLACED_IOV; ++lo){
+            const Block *b = &k->blocks[lo];
+            if (!b->ok) { __atomic_store_n(&k->rc, -1, __ATOMIC_RELAXED); continue; }
+            iov[n].iov_base = b->out;
+            iov[n].iov_len = b->out_len;
+            len += b->out_len;
+            ++n;
+        }
+        if (n && writer_write_at(k->w, iov, n, (off_t)off) != 0) __atomic_store_n(&k->rc, -1, __ATOMIC_RELAXED);
+        off += len;
+    }
+}
+
+// ---- 블록 인덱스 사이드카 (<archive>.idx): 비압축 오프셋 → 압축 오프셋/길이 ----
+// 형식 (little-endian): "PBZIDX1\0", u64 개수, 항목마다 u64 uoff, u64 coff, u32 ulen, u32 clen
+#define IDX_MAGIC   "PBZIDX1"
+#define IDX_HDR     16
+#define IDX_REC     24
+
+typedef struct {
+    uint64_t uoff, coff;
+    uint32_t ulen, clen;
+} IndexEntry;
+
+typedef struct {
+    IndexEntry *e;
+    size_t n, cap;
+} IndexList;
+
+static void put_le(unsigned char *p, uint64_t v, int n){
+    for (int i=0;i<n;++i) p[i] = (unsigned char)(v >> (8*i));
+}
+
+static uint64_t get_le(const unsigned char *p, int n){
+    uint64_t v = 0;
+    for (int i=n-1;i>=0;--i) v = (v << 8) | p[i];
+    return v;
+}
+
+static int index_append(IndexList *l, uint32_t ulen, uint32_t clen){
+    if (l->n == l->cap){
+        size_t ncap = l->cap ? 2 * l->cap : 256;
+        IndexEntry *t = (IndexEntry*)realloc(l->e, ncap * sizeof(*t));
+        if (!t) return -1;
+        l->e = t; l->cap = ncap;
+    }
+    IndexEntry *prev = l->n ? &l->e[l->n - 1] : NULL;
+    l->e[l->n++] = (IndexEntry){
+        .uoff = prev ? prev->uoff + prev->ulen : 0,
+        .coff = prev ? prev->coff + prev->clen : 0,
+        .ulen = ulen, .clen = clen
+    };
+    return 0;
+}
+
+static int index_write(const char *archive, const IndexList *l){
+    if (!strcmp(archive, "-")) { fprintf(stderr, "index: output is stdout, no sidecar written\n"); return 0; }
+    char path[4096];
+    snprintf(path, sizeof(path), "%s.idx", archive);
+    FILE *f = fopen(path, "wb");
+    if (!f) { perror("fopen"); return -1; }
+    unsigned char hdr[IDX_HDR];
+    memcpy(hdr, IDX_MAGIC, 8);
+    put_le(hdr + 8, l->n, 8);
+    int ok = fwrite(hdr, 1, sizeof(hdr), f) == sizeof(hdr);
+    for (size_t i=0;i<l->n && ok;++i){
+        unsigned char rec[IDX_REC];
+        put_le(rec,      l->e[i].uoff, 8);
+        put_le(rec + 8,  l->e[i].coff, 8);
+        put_le(rec + 16, l->e[i].ulen, 4);
+        put_le(rec + 20, l->e[i].clen, 4);
+        ok = fwrite(rec, 1, sizeof(rec), f) == sizeof(rec);
+    }
+    if (!ok) perror("fwrite");
+    if (fclose(f) != 0) { perror("fclose"); ok = 0; }
+    return ok ? 0 : -1;
+}
+
+// 사이드카를 읽고 연속성/압축 파일 크기와 맞는지 확인. 없거나 안 맞으면 -1
+static int index_load(const char *archive, size_t archive_len, IndexList *l){
+    char path[4096];
+    snprintf(path, sizeof(path), "%s.idx", archive);
+    memset(l, 0, sizeof(*l));
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    unsigned char hdr[IDX_HDR], rec[IDX_REC];
+    int ok = fread(hdr, 1, sizeof(hdr), f) == sizeof(hdr) && memcmp(hdr, IDX_MAGIC, 8) == 0;
+    uint64_t n = ok ? get_le(hdr + 8, 8) : 0;
+    for (uint64_t i=0;i<n && ok;++i){
+        ok = fread(rec, 1, sizeof(rec), f) == sizeof(rec) &&
+             index_append(l, (uint32_t)get_le(rec + 16, 4), (uint32_t)get_le(rec + 20, 4)) == 0 &&
+             l->e[i].uoff == get_le(rec, 8) && l->e[i].coff == get_le(rec + 8, 8);
+    }
+    fclose(f);
+    if (ok && l->n) ok = l->e[l->n - 1].coff + l->e[l->n - 1].clen == archive_len;
+    if (!ok || !l->n) { free(l->e); memset(l, 0, sizeof(*l)); return -1; }
+    return 0;
+}
+
+// ---- 큰 버퍼: 블록마다 malloc 하지 않고 한 번 매핑해서 잘라 쓴다 ----
+// 2MB 이상이면 MAP_HUGETLB 를 먼저 시도하고 (예약된 hugepage 가 모자라면 mmap 이 실패한다),
+// 안 되면 일반 매핑에 THP 를 요청한다. 한 번 들어온 페이지는 reset 뒤에도 그대로 재사용
+#define HUGE_PAGE ((size_t)2 << 20)
+enum { PAGES_4K, PAGES_THP, PAGES_HUGETLB };
+static const char *const page_kind[] = { "4k", "thp", "hugetlb" };
+
+typedef struct {
+    unsigned char *base;
+    size_t cap;
+    size_t used;        // bump 오프셋 (워커들이 atomic 으로 당긴다)
+    int kind;
+} Arena;
+
+static int arena_init(Arena *a, size_t cap){
+    memset(a, 0, sizeof(*a));
+    if (cap == 0) cap = 1;
+    void *p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    size_t hcap = (cap + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+    if (cap >= HUGE_PAGE)
+        p = mmap(NULL, hcap, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) { cap = hcap; a->kind = PAGES_HUGETLB; }
+#endif
+    if (p == MAP_FAILED){
+        // 예약만 해 두고 닿은 페이지만 잡힌다
+        p = mmap(NULL, cap, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+        if (p == MAP_FAILED) { perror("mmap"); return -1; }
+#ifdef MADV_HUGEPAGE
+        if (cap >= HUGE_PAGE && madvise(p, cap, MADV_HUGEPAGE) == 0) a->kind = PAGES_THP;
+#endif
+    }
+    a->base = (unsigned char*)p;
+    a->cap = cap;
+    return 0;
+}
+
+static void arena_fini(Arena *a){
+    if (a->base) munmap(a->base, a->cap);
+    memset(a, 0, sizeof(*a));
+}
+
+static inline size_t align64(size_t n){ return (n + 63) & ~(size_t)63; }
+
+// n 바이트를 64B 정렬로 떼어 준다. 모자라면 NULL
+static unsigned char *arena_take(Arena *a, size_t n){
+    size_t off = __atomic_fetch_add(&a->used, align64(n), __ATOMIC_RELAXED);
+    return off + n <= a->cap ? a->base + off : NULL;
+}
+
+static void arena_reset(Arena *a){ a->used = 0; }
+
+// 워커별 상태: 코덱 컨텍스트 (bzip2 할당 캐시, zlib/zstd/lz4 컨텍스트) + 압축 staging 버퍼.
+// pool 의 init/fini 훅으로 워커마다 하나
+typedef struct {
+    const codec *cd;
+    int level;
+    size_t stage_cap;   // > 0 이면 워커마다 이만한 staging 버퍼
+} CodecCfg;
+
+typedef struct {
+    void *ctx;
+    Arena stage;
+} Worker;
+
+static void *codec_worker_init(int thr_idx, void *arg){
+    (void)thr_idx;
+    const CodecCfg *cfg = (const CodecCfg*)arg;
+    Worker *w = (Worker*)calloc(1, sizeof(Worker));
+    if (!w) return NULL;
+    w->ctx = cfg->cd->init(cfg->level);
+    if (!w->ctx || (cfg->stage_cap && arena_init(&w->stage, cfg->stage_cap) != 0)){
+        if (w->ctx) cfg->cd->end(w->ctx);
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+static void codec_worker_fini(int thr_idx, void *local, void *arg){
+    (void)thr_idx;
+    const CodecCfg *cfg = (const CodecCfg*)arg;
+    Worker *w = (Worker*)local;
+    if (!w) return;
+    cfg->cd->end(w->ctx);
+    arena_fini(&w->stage);
+    free(w);
+}
+
+// cfg 는 pool 보다 오래 살아야 한다
+static parallel_pool *make_pool(int nthreads, int pinning, const CodecCfg *cfg){
+    parallel_pool_attr attr;
+    parallel_pool_attr_init(&attr);
+    attr.nthreads = nthreads;
+    attr.options  = pinning & (PARALLEL_OPT_PIN_CORE | PARALLEL_OPT_REALTIME);
+    attr.init     = codec_worker_init;
+    attr.fini     = codec_worker_fini;
+    attr.hook_arg = (void*)cfg;
+    return parallel_pool_create_attr(&attr);
+}
+
+// 현재 워커의 상태, 워커 밖(단일 스레드)이면 fallback
+static Worker *current_worker(Worker *fallback){
+    Worker *w = (Worker*)parallel_worker_local();
+    return w ? w : fallback;
+}
+
+// 블록 하나 = 독립 프레임 하나, b->out 에 바로 쓴다
+static void block_compress(Block *b, const codec *cd, Worker *w){
+    size_t n = 0;
+    b->ok = w && cd->compress(w->ctx, b->in, b->in_len, b->out, b->out_cap, &n) == 0;
+    b->out_len = b->ok ? (unsigned int)n : 0;
+}
+
+typedef struct {
+    Block *blocks;
+    const codec *cd;
+    Arena *out;       // 압축 결과를 빈틈없이 모으는 곳
+    Worker *fallback;
+    OrderedSink *sink;  // 있으면 끝난 블록을 알린다
+    PlacedSink *placed; // 있으면 끝난 블록을 자리에 쓴다
+    int mapped;       // 입력이 mmap 이면 블록마다 WILLNEED
+} CompressCtx;
+
+// 워커 staging 버퍼에 최악 크기로 압축한 뒤 실제 길이만 arena 로 옮긴다.
+// 블록별 최악 크기 버퍼를 따로 두지 않으므로 메모리는 압축 결과 + 워커 수 x 블록 하나
+static void compress_block(long bi, void *ud){
+    CompressCtx *C = (CompressCtx*)ud;
+    Block *b = &C->blocks[bi];
+    Worker *w = current_worker(C->fallback);
+    if (C->mapped) prefetch_range(b->in, b->in_len);
+    if (!w) { b->ok = 0; return; }
+    Block tmp = *b;
+    tmp.out = w->stage.base;
+    tmp.out_cap = (unsigned int)w->stage.cap;
+    block_compress(&tmp, C->cd, w);
+    unsigned char *dst = tmp.ok ? arena_take(C->out, tmp.out_len) : NULL;
+    if (dst) memcpy(dst, tmp.out, tmp.out_len);
+    b->out = dst;
+    b->out_cap = b->out_len = dst ? tmp.out_len : 0;
+    b->ok = dst != NULL;
+    if (C->sink) sink_done(C->sink, bi);
+    if (C->placed) placed_done(C->placed, bi);
+}
+
+// ---- 스트리밍: reader → 블록 링 → 압축 워커들 → 순서대로 writer ----
+// 메모리는 링 크기(2 x threads) x 블록 크기로 고정, 입력 크기와 무관
+enum { SLOT_EMPTY, SLOT_FILLED, SLOT_DONE };
+
+typedef struct {
+    Block blk;
+    unsigned char *inbuf;
+    long seq;
+    int state;
+} Slot;
+
+typedef struct {
+    FILE *in, *out;
+    Slot *slots;
+    int nslots;
+    unsigned int blk;
+    const codec *cd;
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+    long nread;         // 채워진 블록 수
+    long next_comp;     // 다음 압축할 블록 번호
+    int eof, failed;
+    size_t in_bytes, out_bytes;
+    IndexList *idx;     // writer 만 건드림
+} Stream;
+
+static void stream_fail(Stream *S){
+    pthread_mutex_lock(&S->mu);
+    S->failed = 1;
+    pthread_cond_broadcast(&S->cv);
+    pthread_mutex_unlock(&S->mu);
+}
+
+static void *stream_reader(void *arg){
+    Stream *S = (Stream*)arg;
+    for (long seq=0;;++seq){
+        Slot *sl = &S->slots[seq % S->nslots];
+        pthread_mutex_lock(&S->mu);
+        while (sl->state != SLOT_EMPTY && !S->failed) pthread_cond_wait(&S->cv, &S->mu);
+        int failed = S->failed;
+        pthread_mutex_unlock(&S->mu);
+        if (failed) break;
+
+        // fread 는 EOF/에러가 아니면 요청한 만큼 채운다 (파이프 포함)
+        size_t n = fread(sl->inbuf, 1, S->blk, S->in);
+        if (n < S->blk && ferror(S->in)) { perror("fread"); stream_fail(S); break; }
+
+        pthread_mutex_lock(&S->mu);
+        if (n > 0 || seq == 0){     // 빈 입력도 빈 블록 하나 (올바른 빈 프레임)
+            sl->blk.in = sl->inbuf;
+            sl->blk.in_len = (unsigned int)n;
+            sl->blk.out_len = 0;
+            sl->blk.ok = 0;
+            sl->seq = seq;
+            sl->state = SLOT_FILLED;
+            S->nread = seq + 1;
+            S->in_bytes += n;
+        }
+        if (n < S->blk) S->eof = 1;
+        pthread_cond_broadcast(&S->cv);
+        int eof = S->eof;
+        pthread_mutex_unlock(&S->mu);
+        if (eof) break;
+    }
+    return NULL;
+}
+
+// parallel_for 워커 하나가 스트림 끝까지 블록을 가져다 압축한다
+static void stream_compress(long i, void *ud){
+    Stream *S = (Stream*)ud;
+    (void)i;
+    for (;;){
+        pthread_mutex_lock(&S->mu);
+        while (!S->failed && S->next_comp >= S->nread && !S->eof) pthread_cond_wait(&S->cv, &S->mu);
+        if (S->failed || S->next_comp >= S->nread) { pthread_mutex_unlock(&S->mu); return; }
+        Slot *sl = &S->slots[S->next_comp % S->nslots];
+        S->next_comp++;
+        pthread_mutex_unlock(&S->mu);
+
+        block_compress(&sl->blk, S->cd, current_worker(NULL));
+
+        pthread_mutex_lock(&S->mu);
+        if (!sl->blk.ok) S->failed = 1;
+        sl->state = SLOT_DONE;
+        pthread_cond_broadcast(&S->cv);
+        pthread_mutex_unlock(&S->mu);
+    }
+}
+
+static void *stream_writer(void *arg){
+    Stream *S = (Stream*)arg;
+    for (long seq=0;;++seq){
+        Slot *sl = &S->slots[seq % S->nslots];
+        pthread_mutex_lock(&S->mu);
+        while (!S->failed && !(sl->state == SLOT_DONE && sl->seq == seq) && !(S->eof && seq >= S->nread))
+            pthread_cond_wait(&S->cv, &S->mu);
+        int ready = !S->failed && sl->state == SLOT_DONE && sl->seq == seq;
+        pthread_mutex_unlock(&S->mu);
+        if (!ready) break;
+
+        if (fwrite(sl->blk.out, 1, sl->blk.out_len, S->out) != sl->blk.out_len){
+            perror("fwrite");
+            stream_fail(S);
+            break;
+        }
+
+        if (S->idx && index_append(S->idx, sl->blk.in_len, sl->blk.out_len) != 0){
+            stream_fail(S);
+            break;
+        }
+
+        pthread_mutex_lock(&S->mu);
+        S->out_bytes += sl->blk.out_len;
+        sl->state = SLOT_EMPTY;
+        pthread_cond_broadcast(&S->cv);
+        pthread_mutex_unlock(&S->mu);
+    }
+    return NULL;
+}
+
+static int compress_stream(FILE *in, FILE *out, parallel_pool *pool, const codec *cd, unsigned int blk,
+                           IndexList *idx, size_t *in_bytes, size_t *out_bytes){
+    int nthreads = parallel_pool_size(pool);
+    Stream S;
+    memset(&S, 0, sizeof(S));
+    S.in = in; S.out = out; S.blk = blk; S.cd = cd; S.idx = idx;
+    S.nslots = 2 * nthreads;
+    S.slots = (Slot*)calloc((size_t)S.nslots, sizeof(Slot));
+    if (!S.slots) return -1;
+    // 링의 입력/출력 버퍼 전부를 매핑 하나에서
+    size_t out_cap = cd->bound(blk);
+    Arena bufs;
+    if (arena_init(&bufs, (size_t)S.nslots * (align64(blk) + align64(out_cap))) != 0){
+        free(S.slots);
+        return -1;
+    }
+    int rc = 0;
+    for (int i=0;i<S.nslots && rc==0;++i){
+        Slot *sl = &S.slots[i];
+        sl->inbuf = arena_take(&bufs, blk);
+        sl->blk.out_cap = (unsigned int)out_cap;
+        sl->blk.out = arena_take(&bufs, out_cap);
+        if (!sl->inbuf || !sl->blk.out) rc = -1;
+    }
+    pthread_mutex_init(&S.mu, NULL);
+    pthread_cond_init(&S.cv, NULL);
+
+    pthread_t rd, wr;
+    if (rc == 0 && pthread_create(&rd, NULL, stream_reader, &S) != 0) rc = -1;
+    if (rc == 0 && pthread_create(&wr, NULL, stream_writer, &S) != 0) { stream_fail(&S); pthread_join(rd, NULL); rc = -1; }
+    if (rc == 0){
+        if (parallel_pool_for(pool, 0, nthreads, 1, PARALLEL_OPT_SCHED_SHARED, stream_compress, &S) != 0)
+            stream_fail(&S);
+        pthread_join(rd, NULL);
+        pthread_join(wr, NULL);
+        if (S.failed) rc = -1;
+    }
+
+    *in_bytes = S.in_bytes;
+    *out_bytes = S.out_bytes;
+    pthread_cond_destroy(&S.cv);
+    pthread_mutex_destroy(&S.mu);
+    arena_fini(&bufs);
+    free(S.slots);
+    return rc;
+}
+
+// ---- 병렬 해제: 이어 붙인 프레임들을 경계에서 나눠 동시에 푼다 ----
+typedef struct {
+    const unsigned char *in;
+    size_t in_len;
+    unsigned char *out;
+    size_t out_len, out_cap;
+    int fixed;          // out 은 인덱스로 정확히 잡아 둔 자리: 늘리지 않는다
+    int ok;
+} Segment;
+
+typedef struct {
+    Segment *segs;
+    const codec *cd;
+} DecodeCtx;
+
+// 프레임 시작 오프셋 목록. 압축 데이터 안의 우연한 일치는 해제 실패로 드러나고
+// 그 경우 호출자가 직렬 해제로 되돌린다
+static size_t find_streams(const codec *cd, const unsigned char *p, size_t n, size_t **offs_out){
+    size_t cap = 64, cnt = 0;
+    size_t *offs = (size_t*)malloc(cap * sizeof(*offs));
+    if (!offs) return 0;
+    const size_t tail = cd->frame_hdr;
+    for (size_t i = 0; n >= tail && i <= n - tail; ){
+        const unsigned char *q = (const unsigned char*)memchr(p + i, cd->magic[0], n - tail + 1 - i);
+        if (!q) break;
+        i = (size_t)(q - p);
+        if (cd->frame_start(q, n - i)){
+            if (cnt == cap){
+                size_t *t = (size_t*)realloc(offs, 2 * cap * sizeof(*offs));
+                if (!t) { free(offs); return 0; }
+                offs = t; cap *= 2;
+            }
+            offs[cnt++] = i;
+            i += tail;
+        } else {
+            ++i;
+        }
+    }
+    *offs_out = offs;
+    return cnt;
+}
+
+// 구간 하나 해제 (구간 안에 프레임이 여러 개여도 이어서 푼다)
+static void segment_decode(Segment *sg, const codec *cd, Worker *fallback){
+    Worker *w = current_worker(fallback);
+    void *ctx = w ? w->ctx : NULL;
+    sg->ok = 0;
+    sg->out_len = 0;
+    if (!ctx) return;
+    if (!sg->out){
+        sg->out_cap = sg->in_len * 4 + 4096;
+        sg->out = (unsigned char*)malloc(sg->out_cap);
+        if (!sg->out) return;
+    }
+
+    size_t consumed = 0;
+    while (consumed < sg->in_len){
+        if (cd->decode_begin(ctx) != 0) return;
+        int rc;
+        do {
+            if (sg->out_len == sg->out_cap && !sg->fixed){
+                size_t ncap = sg->out_cap * 2;
+                unsigned char *t = (unsigned char*)realloc(sg->out, ncap);
+                if (!t) return;
+                sg->out = t; sg->out_cap = ncap;
+            }
+            // 고정 자리가 꽉 찼으면 프레임 끝만 확인한다. 한 바이트라도 더 나오면 인덱스가 틀린 것
+            unsigned char spill;
+            int full = sg->out_len == sg->out_cap;
+            size_t in_used = 0, out_used = 0;
+            rc = cd->decode(ctx, sg->in + consumed, sg->in_len - consumed, &in_used,
+                            full ? &spill : sg->out + sg->out_len, full ? 1 : sg->out_cap - sg->out_len, &out_used);
+            if (full && out_used) return;
+            consumed += in_used;
+            sg->out_len += out_used;
+            if (rc == CODEC_MORE && in_used == 0 && out_used == 0) return;    // 입력이 중간에 끊겼다
+        } while (rc == CODEC_MORE);
+        if (rc != CODEC_FRAME_END) return;
+    }
+    sg->ok = !sg->fixed || sg->out_len == sg->out_cap;
+}
+
+static void decompress_segment(long i, void *ud){
+    DecodeCtx *D = (DecodeCtx*)ud;
+    segment_decode(&D->segs[i], D->cd, NULL);
+}
+
+// 입력 앞의 매직으로 코덱을 고른다. 빈 입력도 올바른 압축 데이터가 아니다 (빈 원본도 프레임이 있다)
+static const codec *detect_input(const unsigned char *in, size_t in_len){
+    if (!in_len) { fprintf(stderr, "compressed input is empty (truncated)\n"); return NULL; }
+    const codec *cd = codec_detect(in, in_len);
+    if (!cd) fprintf(stderr, "unrecognised input format (codecs in this build: %s)\n", codec_names());
+    return cd;
+}
+
+// ---- 실행 옵션 ----
+typedef struct {
+    const codec *cd;
+    int level;
+    unsigned int blk;       // 압축 블록 크기
+    int nthreads;           // <= 0 이면 parallel_default_threads()
+    int pinning;            // PARALLEL_OPT_PIN_CORE | PARALLEL_OPT_REALTIME
+    long chunk;
+    int sched;
+    const char *sched_name;
+    int use_mmap;           // 파일 입력을 mmap (기본), 아니면 malloc 사본
+    int want_idx;
+    int wflags;             // WRITER_*
+    int stream;             // 파일도 스트리밍 경로로 (메모리 O(threads x block))
+    int bench;              // 직렬 압축을 먼저 재서 속도 비교
+    int verbose;            // 통계를 stderr 로
+    int perf;               // 압축 루프의 하드웨어 카운터 (PARALLEL_OPT_PERF) 를 함께
+} Opts;
+
+// 압축 스트림 전체를 메모리로 (stdin 해제용: 경계 탐색에 전체가 필요하다)
+static unsigned char *read_all(FILE *f, size_t *len_out){
+    size_t cap = 1 << 20, n = 0;
+    unsigned char *buf = (unsigned char*)malloc(cap);
+    if (!buf) return NULL;
+    for (;;){
+        if (n == cap){
+            unsigned char *t = (unsigned char*)realloc(buf, 2 * cap);
+            if (!t) { free(buf); return NULL; }
+            buf = t; cap *= 2;
+        }
+        size_t got = fread(buf + n, 1, cap - n, f);
+        n += got;
+        if (got == 0){
+            if (ferror(f)) { perror("fread"); free(buf); return NULL; }
+            break;
+        }
+    }
+    *len_out = n;
+    return buf;
+}
+
+static FILE *open_out(const char *path){
+    FILE *out = strcmp(path, "-") ? fopen(path, "wb") : stdout;
+    if (!out) perror(path);
+    return out;
+}
+
+static int close_out(FILE *out){
+    if (out == stdout){
+        if (fflush(out) != 0) { perror("fflush"); return -1; }
+    } else if (fclose(out) != 0) { perror("fclose"); return -1; }
+    return 0;
+}
+
+// in_path "-" 는 stdin. 인덱스 (<in>.idx) 가 있으면 블록 경계와 출력 자리를 그대로 쓴다
+static int run_decompress(const char *in_path, const char *out_path, const Opts *o){
+    int from_stdin = !strcmp(in_path, "-");
+    int mapped = !from_stdin && o->use_mmap;
+    size_t in_len = 0;
+    unsigned char *in = from_stdin ? read_all(stdin, &in_len)
+                      : mapped ? map_file(in_path, &in_len) : read_file(in_path, &in_len);
+    if (!in) { fprintf(stderr, "%s: failed to read input\n", in_path); return 1; }
+    const codec *cd = detect_input(in, in_len);
+    if (!cd) { release_input(in, in_len, mapped); return 1; }
+    CodecCfg cfg = { cd, cd->level_default, 0 };
+
+    double t0 = sec_now();
+    Segment *segs = NULL;
+    size_t nseg = 0;
+    unsigned char *arena = NULL;    // 인덱스가 있으면 전체 출력을 한 번에 잡는다
+    IndexList idx;
+    if (!from_stdin && index_load(in_path, in_len, &idx) == 0){
+        uint64_t total = idx.e[idx.n - 1].uoff + idx.e[idx.n - 1].ulen;
+        nseg = idx.n;
+        segs = (Segment*)calloc(nseg, sizeof(Segment));
+        arena = (unsigned char*)malloc(total ? total : 1);
+        if (!segs || !arena) { free(segs); free(arena); free(idx.e); release_input(in, in_len, mapped); return 1; }
+        for (size_t i=0;i<nseg;++i){
+            segs[i].in = in + idx.e[i].coff;
+            segs[i].in_len = idx.e[i].clen;
+            segs[i].out = arena + idx.e[i].uoff;
+            segs[i].out_cap = idx.e[i].ulen;
+            segs[i].fixed = 1;
+        }
+        free(idx.e);
+    } else {
+        size_t *offs = NULL;
+        size_t ns = find_streams(cd, in, in_len, &offs);
+        if (ns == 0 || offs[0] != 0) ns = 0;       // 경계를 못 찾으면 통째로 한 구간
+        nseg = ns ? ns : 1;
+        segs = (Segment*)calloc(nseg, sizeof(Segment));
+        if (!segs) { free(offs); release_input(in, in_len, mapped); return 1; }
+        for (size_t i=0;i<nseg;++i){
+            size_t lo = ns ? offs[i] : 0;
+            size_t hi = (ns && i + 1 < ns) ? offs[i + 1] : in_len;
+            segs[i].in = in + lo;
+            segs[i].in_len = hi - lo;
+        }
+        free(offs);
+    }
+    double t1 = sec_now();
+
+    int ok = 0;
+    parallel_pool *pool = make_pool(o->nthreads, o->pinning, &cfg);
+    if (!pool) { fprintf(stderr, "parallel_pool_create failed\n"); goto done; }
+    int thr = parallel_pool_size(pool);
+    DecodeCtx D = { segs, cd };
+    int rc = parallel_pool_for(pool, 0, (long)nseg, o->chunk, o->sched, decompress_segment, &D);
+    parallel_pool_destroy(pool);
+
+    ok = rc == 0;
+    for (size_t i=0;i<nseg && ok;++i) ok = segs[i].ok;
+    if (!ok && nseg > 1 && !arena){
+        // 잘못 짚은 경계가 있었다: 전체를 한 구간으로 직렬 해제
+        if (o->verbose) fprintf(stderr, "stream split failed, falling back to serial decode\n");
+        for (size_t i=1;i<nseg;++i) free(segs[i].out);
+        segs[0].in_len = in_len;
+        nseg = 1;
+        Worker *w = (Worker*)codec_worker_init(0, &cfg);
+        segment_decode(&segs[0], cd, w);
+        codec_worker_fini(0, w, &cfg);
+        ok = segs[0].ok;
+    }
+    double t2 = sec_now();
+
+    size_t out_bytes = 0;
+    if (ok){
+        FILE *out = open_out(out_path);
+        ok = out != NULL;
+        for (size_t i=0;i<nseg && ok;++i){
+            if (fwrite(segs[i].out, 1, segs[i].out_len, out) != segs[i].out_len) { perror("fwrite"); ok = 0; }
+            out_bytes += segs[i].out_len;
+        }
+        if (out && close_out(out) != 0) ok = 0;
+    } else {
+        fprintf(stderr, "%s: decompress failed (corrupt or truncated %s data)\n", in_path, cd->name);
+    }
+    double t3 = sec_now();
+
+    if (ok && o->verbose)
+        fprintf(stderr, "%s: decompress(%s, %d thr, %zu streams%s): %.2f MB -> %.2f MB  scan %.3fs  decode %.3fs  write %.3fs  (%.2f MB/s)\n",
+                in_path, cd->name, thr, nseg, arena ? ", indexed" : "", in_len/1048576.0, out_bytes/1048576.0,
+                t1 - t0, t2 - t1, t3 - t2, (out_bytes/1048576.0) / (t2 - t0));
+
+done:
+    if (arena) free(arena);
+    else for (size_t i=0;i<nseg;++i) free(segs[i].out);
+    free(segs);
+    release_input(in, in_len, mapped);
+    return ok ? 0 : 1;
+}
+
+// 인덱스로 [off, off+len) 을 덮는 블록만 골라 푼다. 아카이브는 mmap 이라 건드린 페이지만 읽힌다
+static int run_extract(const char *in_path, const char *out_path, const char *range, const Opts *o){
+    char *end;
+    unsigned long long off = strtoull(range, &end, 10), len = 0;
+    if (*end != ':' || (len = strtoull(end + 1, &end, 10), *end)) { fprintf(stderr, "bad range '%s' (want OFFSET:LEN)\n", range); return 1; }
+
+    size_t in_len = 0;
+    unsigned char *in = map_file(in_path, &in_len);
+    if (!in) { fprintf(stderr, "%s: failed to read input\n", in_path); return 1; }
+    const codec *cd = detect_input(in, in_len);
+    if (!cd) { release_input(in, in_len, 1); return 1; }
+    CodecCfg cfg = { cd, cd->level_default, 0 };
+    IndexList idx;
+    if (index_load(in_path, in_len, &idx) != 0){
+        fprintf(stderr, "%s.idx missing or does not match %s\n", in_path, in_path);
+        release_input(in, in_len, 1);
+        return 1;
+    }
+
+    double t0 = sec_now();
+    uint64_t total = idx.e[idx.n - 1].uoff + idx.e[idx.n - 1].ulen;
+    if (off > total){
+        fprintf(stderr, "%s: offset %llu is past the end (%llu bytes)\n", in_path, off, (unsigned long long)total);
+        free(idx.e);
+        release_input(in, in_len, 1);
+        return 1;
+    }
+    if (len > total - off) len = total - off;
+
+    // uoff + ulen > off 인 첫 블록부터 uoff < off + len 인 마지막 블록까지
+    size_t lo = 0, hi = idx.n;
+    while (lo < hi){ size_t mid = lo + (hi - lo)/2; if (idx.e[mid].uoff + idx.e[mid].ulen <= off) lo = mid + 1; else hi = mid; }
+    size_t first = lo, last = first;
+    while (last < idx.n && idx.e[last].uoff < off + len) ++last;
+    size_t nseg = last - first;
+
+    int ok = 1, thr = 0;
+    Segment *segs = NULL;
+    unsigned char *arena = NULL;
+    uint64_t base = nseg ? idx.e[first].uoff : off;
+    if (nseg > 0){
+        uint64_t span = idx.e[last - 1].uoff + idx.e[last - 1].ulen - base;
+        segs = (Segment*)calloc(nseg, sizeof(Segment));
+        arena = (unsigned char*)malloc(span);
+        ok = segs && arena;
+        for (size_t i=0;i<nseg && ok;++i){
+            const IndexEntry *e = &idx.e[first + i];
+            segs[i] = (Segment){ .in = in + e->coff, .in_len = e->clen,
+                                 .out = arena + (e->uoff - base), .out_cap = e->ulen, .fixed = 1 };
+        }
+        parallel_pool *pool = ok ? make_pool(o->nthreads, o->pinning, &cfg) : NULL;
+        if (ok && !pool) { fprintf(stderr, "parallel_pool_create failed\n"); ok = 0; }
+        if (ok){
+            thr = parallel_pool_size(pool);
+            DecodeCtx D = { segs, cd };
+            ok = parallel_pool_for(pool, 0, (long)nseg, o->chunk, o->sched, decompress_segment, &D) == 0;
+            parallel_pool_destroy(pool);
+        }
+        for (size_t i=0;i<nseg && ok;++i) ok = segs[i].ok;
+        if (!ok) fprintf(stderr, "%s: extract failed\n", in_path);
+    }
+    // 빈 범위 (LEN 0, 끝 위치) 도 출력은 만든다
+    if (ok){
+        FILE *out = open_out(out_path);
+        ok = out != NULL;
+        if (ok && len && fwrite(arena + (off - base), 1, (size_t)len, out) != (size_t)len) { perror("fwrite"); ok = 0; }
+        if (out && close_out(out) != 0) ok = 0;
+    }
+    double t1 = sec_now();
+    if (ok && o->verbose)
+        fprintf(stderr, "extract(%d thr): %llu bytes @%llu from %zu of %zu blocks in %.3fs\n",
+                thr, len, off, nseg, idx.n, t1 - t0);
+
+    free(segs); free(arena); free(idx.e);
+    release_input(in, in_len, 1);
+    return ok ? 0 : 1;
+}
+
+// 스트리밍 압축: stdin 이나 --stream. 메모리는 입력 크기와 무관하게 링 크기만큼
+static int run_stream(const char *in_path, const char *out_path, const Opts *o){
+    FILE *in  = strcmp(in_path, "-") ? fopen(in_path, "rb") : stdin;
+    if (!in) { perror(in_path); return 1; }
+    FILE *out = open_out(out_path);
+    if (!out) { if (in != stdin) fclose(in); return 1; }
+
+    CodecCfg wcfg = { o->cd, o->level, 0 };     // 링 슬롯에 바로 압축한다
+    parallel_pool *pool = make_pool(o->nthreads, o->pinning, &wcfg);
+    if (!pool){
+        fprintf(stderr, "parallel_pool_create failed\n");
+        if (in != stdin) fclose(in);
+        close_out(out);
+        return 1;
+    }
+
+    int thr = parallel_pool_size(pool);
+    size_t in_bytes = 0, out_bytes = 0;
+    double t0 = sec_now();
+    IndexList idx = {0};
+    int rc = compress_stream(in, out, pool, o->cd, o->blk, o->want_idx ? &idx : NULL, &in_bytes, &out_bytes);
+    double t1 = sec_now();
+    parallel_pool_destroy(pool);
+    if (rc == 0 && o->want_idx && index_write(out_path, &idx) != 0) rc = -1;
+    free(idx.e);
+
+    if (in != stdin) fclose(in);
+    if (close_out(out) != 0) rc = -1;
+    if (rc != 0) { fprintf(stderr, "%s: compress failed\n", in_path); return 1; }
+
+    if (o->verbose)
+        fprintf(stderr, "%s: stream(%s -%d, %d thr, pin=%d): %.2f MB -> %.2f MB in %.3fs  (%.2f MB/s)\n",
+                in_path, o->cd->name, o->level, thr, o->pinning,
+                in_bytes/1048576.0, out_bytes/1048576.0, t1 - t0, (in_bytes/1048576.0) / (t1 - t0));
+    return 0;
+}
+
+// --perf: 방금 끝난 압축 루프의 워커 합. IPC 가 낮고 KB 당 LLC miss 가 많으면 메모리에 묶인 것
+static void print_perf(size_t in_len){
+    parallel_stats st;
+    if (parallel_last_stats(&st) != 0) return;
+    const parallel_perf_counts *c = &st.perf;
+    if (c->cycles < 0 && c->context_switches < 0) { fprintf(stderr, "  perf counters unavailable\n"); return; }
+    fprintf(stderr, "  perf:");
+    const char *sep = " ";
+    if (c->cycles > 0 && c->instructions >= 0){
+        fprintf(stderr, "%s%.2f IPC (%.2f Gcycles)", sep, (double)c->instructions / (double)c->cycles, c->cycles / 1e9);
+        sep = ", ";
+    }
+    if (c->llc_misses >= 0){
+        fprintf(stderr, "%sLLC misses %ld (%.1f/KB in)", sep, c->llc_misses, c->llc_misses / (in_len / 1024.0 + 1e-9));
+        sep = ", ";
+    }
+    if (c->branch_misses >= 0){ fprintf(stderr, "%sbranch misses %ld", sep, c->branch_misses); sep = ", "; }
+    if (c->context_switches >= 0) fprintf(stderr, "%scontext switches %ld", sep, c->context_switches);
+    fprintf(stderr, "\n");
+}
+
+// 파일 하나 통째로: 블록 병렬 압축, 끝나는 대로 제 오프셋에 (stdout / O_DIRECT 는 앞에서부터 writer 로).
+// bench 면 같은 블록을 직렬로 먼저 압축해서 (쓰지 않고) 속도를 비교한다
+static int run_compress_file(const char *in_path, const char *out_path, const Opts *o){
+    const codec *cd = o->cd;
+    const unsigned int BLK = o->blk;
+    CodecCfg cfg = { cd, o->level, cd->bound(BLK) };
+    size_t in_len = 0;
+    unsigned char *in = o->use_mmap ? map_file(in_path, &in_len) : read_file(in_path, &in_len);
+    if (!in) { fprintf(stderr, "%s: failed to read input\n", in_path); return 1; }
+    if (o->bench)
+        fprintf(stderr, "Input: %s (%.2f MB%s), %s -%d, block %u KB\n",
+                in_path, in_len/1048576.0, o->use_mmap ? ", mmap" : "", cd->name, o->level, BLK / 1024);
+
+    // 블록화. 빈 입력도 길이 0 블록 하나로 압축해야 올바른 빈 프레임이 나온다
+    size_t nb = in_len ? (in_len + BLK - 1) / BLK : 1;
+    Block *blocks = (Block*)calloc(nb, sizeof(Block));
+    if (!blocks) { release_input(in, in_len, o->use_mmap); fprintf(stderr,"alloc blocks failed\n"); return 1; }
+
+    // 압축 결과 arena 는 최악 크기 합만큼 예약만 하고, 실제로는 압축된 만큼만 닿는다
+    size_t reserve = 0;
+    for (size_t i=0;i<nb;++i){
+        size_t off = i * (size_t)BLK;
+        size_t len = (off + BLK <= in_len) ? BLK : (in_len - off);
+        blocks[i].in = in + off;
+        blocks[i].in_len = (unsigned int)len;
+        reserve += align64(cd->bound(len));
+    }
+    Arena out_arena;
+    if (arena_init(&out_arena, reserve) != 0) { free(blocks); release_input(in, in_len, o->use_mmap); return 1; }
+
+    int rc = 0;
+    double single_s = 0;
+    if (o->bench){
+        // 단일 스레드 참조 속도. arena 페이지는 여기서 들어와 병렬 쪽이 그대로 재사용한다
+        Worker *serial = (Worker*)codec_worker_init(0, &cfg);
+        CompressCtx S = { .blocks = blocks, .cd = cd, .out = &out_arena, .fallback = serial, .mapped = o->use_mmap };
+        double t0 = sec_now();
+        for (size_t i=0;i<nb && rc==0;++i){
+            compress_block((long)i, &S);
+            if (!blocks[i].ok) { fprintf(stderr,"single compress fail @%zu\n", i); rc = -1; }
+        }
+        single_s = sec_now() - t0;
+        codec_worker_fini(0, serial, &cfg);
+        if (rc == 0)
+            fprintf(stderr, "single-thread: %.3fs  (%.2f MB/s), output %.2f MB\n",
+                    single_s, (in_len / 1048576.0) / single_s, out_arena.used/1048576.0);
+        for (size_t i=0;i<nb;++i){ blocks[i].ok = 0; blocks[i].out_len = 0; }
+        arena_reset(&out_arena);
+    }
+
+    // 일반 파일이면 워커가 자리를 잡아 바로 쓰고, stdout / O_DIRECT 는 sink 스레드가 순서대로 이어 쓴다
+    int placed = strcmp(out_path, "-") != 0 && !(o->wflags & WRITER_DIRECT);
+    OrderedSink K = { .blocks = blocks, .nb = nb };
+    PlacedSink P = { .blocks = blocks, .nb = nb };
+    unsigned char *done = rc == 0 ? (unsigned char*)calloc(nb, 1) : NULL;
+    writer *w = done ? writer_open(out_path, o->wflags | (placed ? WRITER_PLACED : 0)) : NULL;
+    if (!w){
+        if (rc == 0) fprintf(stderr, "%s: cannot open output\n", out_path);
+        free(done); arena_fini(&out_arena); free(blocks); release_input(in, in_len, o->use_mmap);
+        return 1;
+    }
+    if (placed) { P.done = done; P.w = w; }
+    else        { K.done = done; K.w = w; }
+    pthread_mutex_init(&K.mu, NULL);
+    pthread_cond_init(&K.cv, NULL);
+    pthread_mutex_init(&P.mu, NULL);
+    char backend[32];
+    snprintf(backend, sizeof(backend), "%s", writer_backend(w));
+
+    CompressCtx C = { .blocks = blocks, .cd = cd, .out = &out_arena, .mapped = o->use_mmap };
+    if (placed) C.placed = &P; else C.sink = &K;
+    double p0 = sec_now();
+    pthread_t sink_th;
+    int thr = 0;
+    if (!placed && pthread_create(&sink_th, NULL, sink_main, &K) != 0){
+        fprintf(stderr, "pthread_create failed\n");
+        writer_close(w);
+        rc = -1;
+    } else {
+        parallel_pool *pool = make_pool(o->nthreads, o->pinning, &cfg);
+        if (!pool) fprintf(stderr, "parallel_pool_create failed\n");
+        thr = parallel_pool_size(pool);
+        int opts = o->sched | (o->perf ? PARALLEL_OPT_PERF : 0);
+        if (pool) rc = parallel_pool_for(pool, 0, (long)nb, o->chunk, opts, compress_block, &C);
+        if (!pool) rc = -2;
+        parallel_pool_destroy(pool);
+        if (placed){
+            if (P.frontier != nb) P.rc = -1;
+            if (writer_close(w) != 0) P.rc = -1;
+        } else {
+            sink_abort(&K);
+            pthread_join(sink_th, NULL);
+        }
+        if (rc != 0) fprintf(stderr, "parallel_for failed: %d\n", rc);
+    }
+    double p1 = sec_now();
+    pthread_mutex_destroy(&P.mu);
+    pthread_cond_destroy(&K.cv);
+    pthread_mutex_destroy(&K.mu);
+    free(done);
+
+    for (size_t i=0;i<nb && rc==0;++i){
+        if (!blocks[i].ok) { fprintf(stderr,"%s: compress failed at block %zu\n", in_path, i); rc = -1; }
+    }
+    if (rc == 0 && (K.rc != 0 || P.rc != 0)) { fprintf(stderr, "writing %s failed\n", out_path); rc = -1; }
+
+    if (rc == 0 && (o->verbose || o->bench)){
+        double par_s = p1 - p0;
+        fprintf(stderr, "%s: parallel(%s -%d, %d thr, pin=%d, chunk=%ld, sched=%s): %.2f MB -> %.2f MB in %.3fs  (%.2f MB/s)\n",
+                in_path, cd->name, o->level, thr, o->pinning, o->chunk, o->sched_name,
+                in_len/1048576.0, out_arena.used/1048576.0, par_s, (in_len / 1048576.0) / par_s);
+        fprintf(stderr, "  output arena %.2f MB reserved (%s pages), write %s%s overlapped with compression\n",
+                out_arena.cap/1048576.0, page_kind[out_arena.kind], backend, placed ? " from workers" : "");
+        if (o->bench) fprintf(stderr, "speedup: %.2fx\n", single_s / par_s);
+        if (o->perf) print_perf(in_len);
+    }
+
+    // 인덱스는 블록 길이가 다 정해진 뒤에
+    IndexList idx = {0};
+    for (size_t i=0;i<nb && o->want_idx && rc==0;++i){
+        if (index_append(&idx, blocks[i].in_len, blocks[i].out_len) != 0) { fprintf(stderr, "index alloc failed\n"); rc = -1; }
+    }
+    if (rc == 0 && o->want_idx && index_write(out_path, &idx) != 0) rc = -1;
+    free(idx.e);
+
+    arena_fini(&out_arena);
+    free(blocks); release_input(in, in_len, o->use_mmap);
+    return rc == 0 ? 0 : 1;
+}
+
+// ---- CLI ----
+typedef struct {
+    int decompress, to_stdout, keep, force, test;
+    const char *out_path, *extract;
+} Mode;
+
+// name 이 빌드에 있는 코덱의 접미사로 끝나면 그 길이
+static size_t codec_suffix_len(const char *name){
+    size_t n = strlen(name);
+    static const char *const names[] = { "bzip2", "gzip", "zstd", "lz4" };
+    for (size_t i=0;i<sizeof(names)/sizeof(names[0]);++i){
+        const codec *cd = codec_find(names[i]);
+        if (!cd) continue;
+        size_t s = strlen(cd->suffix);
+        if (n > s && !strcmp(name + n - s, cd->suffix)) return s;
+    }
+    return 0;
+}
+
+static int file_exists(const char *path){
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+static int unlink_if(const char *path){
+    if (unlink(path) != 0 && errno != ENOENT) { perror(path); return -1; }
+    return 0;
+}
+
+// 파일 하나 (또는 "-") 처리. 성공하고 stdout 이 아니면 -k 가 없는 한 입력을 지운다 (bzip2 와 같다)
+static int process(const char *in_path, const Mode *m, const Opts *o){
+    int from_stdin = !strcmp(in_path, "-");
+    struct stat st;
+    // 입력을 먼저 확인: 실패 정리에서 남의 출력 파일을 지우지 않게
+    if (!from_stdin){
+        if (stat(in_path, &st) != 0) { perror(in_path); return 1; }
+        if (!S_ISREG(st.st_mode)) { fprintf(stderr, "%s: not a regular file, skipping\n", in_path); return 1; }
+    }
+    char out_buf[4096];
+    const char *out_path;
+    if (m->test)                              out_path = "/dev/null";
+    else if (m->out_path)                     out_path = m->out_path;
+    else if (m->to_stdout || from_stdin || m->extract) out_path = "-";
+    else if (m->decompress){
+        size_t s = codec_suffix_len(in_path);
+        if (s) snprintf(out_buf, sizeof(out_buf), "%.*s", (int)(strlen(in_path) - s), in_path);
+        else   snprintf(out_buf, sizeof(out_buf), "%s.out", in_path);
+        out_path = out_buf;
+    } else {
+        if (codec_suffix_len(in_path) && !m->force){
+            fprintf(stderr, "%s: already has a compressed suffix, skipping (use -f)\n", in_path);
+            return 1;
+        }
+        snprintf(out_buf, sizeof(out_buf), "%s%s", in_path, o->cd->suffix);
+        out_path = out_buf;
+    }
+
+    int to_stdout = !strcmp(out_path, "-");
+    if (to_stdout && !m->decompress && !m->extract && !m->test && !m->force && isatty(STDOUT_FILENO)){
+        fprintf(stderr, "refusing to write compressed data to a terminal (use -f)\n");
+        return 1;
+    }
+    if (!to_stdout && !m->test && !m->force && file_exists(out_path)){
+        fprintf(stderr, "%s: output file exists (use -f to overwrite)\n", out_path);
+        return 1;
+    }
+
+    int rc;
+    if (m->extract)         rc = run_extract(in_path, out_path, m->extract, o);
+    else if (m->decompress) rc = run_decompress(in_path, out_path, o);
+    else if (from_stdin || o->stream) rc = run_stream(in_path, out_path, o);
+    else                    rc = run_compress_file(in_path, out_path, o);
+
+    int owns_out = !to_stdout && !m->test;
+    if (rc != 0){
+        // 반쯤 쓴 출력은 남기지 않는다
+        if (owns_out) unlink_if(out_path);
+        return 1;
+    }
+    if (!m->keep && !m->test && !m->extract && owns_out && !from_stdin){
+        char idx_path[4096];
+        snprintf(idx_path, sizeof(idx_path), "%s.idx", in_path);
+        if (unlink_if(in_path) != 0) return 1;
+        if (m->decompress) unlink_if(idx_path);
+    }
+    return 0;
+}
+
+static void usage(const char *prog){
+    fprintf(stderr,
+        "Usage: %s [options] [file ...]   (no file or '-': stdin to stdout)\n"
+        "  -d, --decompress      decompress (format detected from the data)\n"
+        "  -z, --compress        compress (default)\n"
+        "  -t, --test            decompress and discard, report errors only\n"
+        "  -c, --stdout          write to stdout, keep input files\n"
+        "  -o, --output FILE     write to FILE (single input only)\n"
+        "  -k, --keep            keep input files (default: remove after success)\n"
+        "  -f, --force           overwrite outputs, compress to a terminal\n"
+        "  -T, --threads N       worker threads (default: usable CPUs, cgroup quota)\n"
+        "  -b, --block-size N    block size, k/m suffix (default 900k)\n"
+        "  -1 .. -9              compression level\n"
+        "  -L, --level N         compression level (codec range, e.g. zstd 1..19)\n"
+        "  -C, --codec NAME      %s (default bzip2)\n"
+        "  -i, --index           write a block index sidecar <output>.idx\n"
+        "  -x, --extract O:L     print bytes [O, O+L) of the original using <file>.idx\n"
+        "  -S, --stream          compress files through the bounded-memory streaming path\n"
+        "      --sched NAME      shared | steal | guided (default) | adaptive | static\n"
+        "      --chunk N         blocks per scheduling chunk (default 1)\n"
+        "      --pin             pin workers to cores\n"
+        "      --no-mmap         read inputs into memory instead of mmap\n"
+        "      --direct          file inputs: write with O_DIRECT (in order, one writer thread)\n"
+        "      --no-uring        ordered writer (stdout, --direct) uses pwritev instead of io_uring\n"
+        "      --bench           time a serial compression first and report the speedup\n"
+        "      --perf            with -v / --bench, report CPU counters of the compression loop\n"
+        "  -v, --verbose         print timing to stderr\n"
+        "  -q, --quiet           no messages except errors\n",
+        prog, codec_names());
+}
+
+static int parse_sched(const char *s){
+    if (!strcmp(s, "shared"))   return PARALLEL_OPT_SCHED_SHARED;
+    if (!strcmp(s, "steal"))    return PARALLEL_OPT_SCHED_STEAL;
+    if (!strcmp(s, "guided"))   return PARALLEL_OPT_SCHED_GUIDED;
+    if (!strcmp(s, "adaptive")) return PARALLEL_OPT_SCHED_ADAPTIVE;
+    if (!strcmp(s, "static"))   return PARALLEL_OPT_SCHED_STATIC;
+    return -1;
+}
+
+// 정수 옵션 하나: 숫자 전체가 [min, max] 안이면 0
+static int parse_num(const char *s, long min, long max, long *out){
+    char *end;
+    errno = 0;
+    long v = strtol(s, &end, 10);
+    if (end == s || *end || errno == ERANGE || v < min || v > max) return -1;
+    *out = v;
+    return 0;
+}
+
+// "900k", "4m", "1048576"
+static long parse_size(const char *s){
+    char *end;
+    long v = strtol(s, &end, 10);
+    if (end == s || v <= 0) return -1;
+    if (*end == 'k' || *end == 'K') { v <<= 10; ++end; }
+    else if (*end == 'm' || *end == 'M') { v <<= 20; ++end; }
+    return *end ? -1 : v;
+}
+
+enum { OPT_SCHED = 256, OPT_CHUNK, OPT_PIN, OPT_NO_MMAP, OPT_DIRECT, OPT_NO_URING, OPT_BENCH, OPT_PERF };
+
+int main(int argc, char **argv){
+    const char *prog = argv[0];
+    static const struct option longopts[] = {
+        { "decompress", no_argument,       NULL, 'd' },
+        { "compress",   no_argument,       NULL, 'z' },
+        { "test",       no_argument,       NULL, 't' },
+        { "stdout",     no_argument,       NULL, 'c' },
+        { "output",     required_argument, NULL, 'o' },
+        { "keep",       no_argument,       NULL, 'k' },
+        { "force",      no_argument,       NULL, 'f' },
+        { "threads",    required_argument, NULL, 'T' },
+        { "block-size", required_argument, NULL, 'b' },
+        { "level",      required_argument, NULL, 'L' },
+        { "codec",      required_argument, NULL, 'C' },
+        { "index",      no_argument,       NULL, 'i' },
+        { "extract",    required_argument, NULL, 'x' },
+        { "stream",     no_argument,       NULL, 'S' },
+        { "sched",      required_argument, NULL, OPT_SCHED },
+        { "chunk",      required_argument, NULL, OPT_CHUNK },
+        { "pin",        no_argument,       NULL, OPT_PIN },
+        { "no-mmap",    no_argument,       NULL, OPT_NO_MMAP },
+        { "direct",     no_argument,       NULL, OPT_DIRECT },
+        { "no-uring",   no_argument,       NULL, OPT_NO_URING },
+        { "bench",      no_argument,       NULL, OPT_BENCH },
+        { "perf",       no_argument,       NULL, OPT_PERF },
+        { "verbose",    no_argument,       NULL, 'v' },
+        { "quiet",      no_argument,       NULL, 'q' },
+        { "help",       no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    Mode m = {0};
+    Opts o = { .nthreads = 0, .chunk = 1, .sched = PARALLEL_OPT_SCHED_GUIDED, .sched_name = "guided",
+               .use_mmap = 1 };
+    const char *codec_name = "bzip2";
+    long blk = 900 << 10;
+    int level = -1, opt;
+    long num;
+    while ((opt = getopt_long(argc, argv, "dztco:kfT:b:L:C:ix:Svq123456789h", longopts, NULL)) != -1){
+        switch (opt){
+            case 'd': m.decompress = 1; break;
+            case 'z': m.decompress = 0; break;
+            case 't': m.test = m.decompress = 1; break;
+            case 'c': m.to_stdout = 1; break;
+            case 'o': m.out_path = optarg; break;
+            case 'k': m.keep = 1; break;
+            case 'f': m.force = 1; break;
+            case 'T':
+                if (parse_num(optarg, 0, 4096, &num) != 0) { fprintf(stderr, "bad thread count '%s' (0 .. 4096, 0 = default)\n", optarg); return 1; }
+                o.nthreads = (int)num;
+                break;
+            case 'b': if ((blk = parse_size(optarg)) < 0) { fprintf(stderr, "bad block size '%s'\n", optarg); return 1; } break;
+            case 'L':
+                if (parse_num(optarg, 1, 99, &num) != 0) { fprintf(stderr, "bad level '%s'\n", optarg); return 1; }
+                level = (int)num;
+                break;
+            case 'C': codec_name = optarg; break;
+            case 'i': o.want_idx = 1; break;
+            case 'x': m.extract = optarg; break;
+            case 'S': o.stream = 1; break;
+            case 'v': o.verbose = 1; break;
+            case 'q': o.verbose = 0; break;
+            case OPT_SCHED:
+                o.sched_name = optarg;
+                if ((o.sched = parse_sched(optarg)) < 0) { fprintf(stderr, "unknown scheduler '%s'\n", optarg); return 1; }
+                break;
+            case OPT_CHUNK:
+                if (parse_num(optarg, 1, LONG_MAX, &o.chunk) != 0) { fprintf(stderr, "bad chunk '%s' (blocks, >= 1)\n", optarg); return 1; }
+                break;
+            case OPT_PIN:      o.pinning |= PARALLEL_OPT_PIN_CORE; break;
+            case OPT_NO_MMAP:  o.use_mmap = 0; break;
+            case OPT_DIRECT:   o.wflags |= WRITER_DIRECT; break;
+            case OPT_NO_URING: o.wflags |= WRITER_NO_URING; break;
+            case OPT_BENCH:    o.bench = 1; break;
+            case OPT_PERF:     o.perf = 1; break;
+            case 'h': usage(prog); return 0;
+            default:
+                if (opt >= '1' && opt <= '9') { level = opt - '0'; break; }
+                usage(prog);
+                return 1;
+        }
+    }
+
+    o.cd = codec_find(codec_name);
+    if (!o.cd) { fprintf(stderr, "unknown codec '%s' (this build: %s)\n", codec_name, codec_names()); return 1; }
+    if (level >= 0 && (level < o.cd->level_min || level > o.cd->level_max)){
+        fprintf(stderr, "level %d out of range for %s (%d .. %d)\n", level, o.cd->name, o.cd->level_min, o.cd->level_max);
+        return 1;
+    }
+    o.level = level < 0 ? o.cd->level_default : level;
+    if (blk < 100 << 10) blk = 100 << 10;
+    if (blk > 256L << 20) blk = 256L << 20;       // Block 길이는 unsigned int
+    o.blk = (unsigned int)blk;
+
+    int nfiles = argc - optind;
+    if (m.out_path && nfiles > 1) { fprintf(stderr, "-o takes a single input\n"); return 1; }
+    if (m.extract && nfiles != 1) { fprintf(stderr, "-x needs one indexed archive\n"); return 1; }
+    if (o.bench && (m.decompress || m.extract || o.stream || nfiles == 0)) { fprintf(stderr, "--bench needs input files to compress\n"); return 1; }
+    // writer 는 파일 압축 경로에만 있다: 스트리밍 (-S, stdin) 과 해제는 stdio 로 쓴다
+    int from_stdin = nfiles == 0;
+    for (int i=optind;i<argc;++i) from_stdin |= !strcmp(argv[i], "-");
+    if (o.wflags && (m.decompress || m.extract || o.stream || from_stdin)){
+        fprintf(stderr, "--direct / --no-uring need input files to compress (not -S, stdin, -d or -x)\n");
+        return 1;
+    }
+
+    if (nfiles == 0) return process("-", &m, &o);
+    int rc = 0;
+    for (int i=optind;i<argc;++i) rc |= process(argv[i], &m, &o);
+    return rc;
+}
@@ -0,0 +1,514 @@
+/* array.c — parallel_array.h: 타일 분할 + 런타임 ISA 선택 커널 */
+#define _GNU_SOURCE
+#include "parallel_array.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#  define ARRAY_X86 1
+#elif defined(__aarch64__)
+#  include <arm_neon.h>
+#  define ARRAY_NEON 1
+#endif
+
+/* ---- 커널 ---- */
+
+typedef struct
+{
+    const char *name;
+    void (*affine_f32)(float *d, const float *s, size_t n, float a, float b);
+    void (*affine_f64)(double *d, const double *s, size_t n, double a, double b);
+    // LUT 는 VBMI / NEON 만: AVX2 의 니블 분할 (pshufb 16 번) 은 스칼라보다 느렸다
+    void (*lut_u8)(unsigned char *d, const unsigned char *s, size_t n, const unsigned char *lut);
+    /* non-temporal: d 는 64B 정렬, bytes 는 64 의 배수. NULL 이면 memcpy / 일반 store */
+    void (*stream_copy)(void *d, const void *s, size_t bytes);
+    void (*stream_fill)(void *d, const unsigned char *pattern64, size_t bytes);
+} array_ops;
+
+static void affine_f32_scalar(float *d, const float *s, size_t n, float a, float b)
+{
+    for (size_t i = 0; i < n; ++i) d[i] = a * s[i] + b;
+}
+
+static void affine_f64_scalar(double *d, const double *s, size_t n, double a, double b)
+{
+    for (size_t i = 0; i < n; ++i) d[i] = a * s[i] + b;
+}
+
+static void lut_u8_scalar(unsigned char *d, const unsigned char *s, size_t n, const unsigned char *lut)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        unsigned char c0 = lut[s[i]], c1 = lut[s[i + 1]], c2 = lut[s[i + 2]], c3 = lut[s[i + 3]];
+        d[i] = c0; d[i + 1] = c1; d[i + 2] = c2; d[i + 3] = c3;
+    }
+    for (; i < n; ++i) d[i] = lut[s[i]];
+}
+
+#if defined(ARRAY_X86)
+__attribute__((target("avx2,fma")))
+static void affine_f32_avx2(float *d, const float *s, size_t n, float a, float b)
+{
+    const __m256 va = _mm256_set1_ps(a), vb = _mm256_set1_ps(b);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256 x0 = _mm256_loadu_ps(s + i), x1 = _mm256_loadu_ps(s + i + 8);
+        _mm256_storeu_ps(d + i,     _mm256_fmadd_ps(x0, va, vb));
+        _mm256_storeu_ps(d + i + 8, _mm256_fmadd_ps(x1, va, vb));
+    }
+    for (; i < n; ++i) d[i] = __builtin_fmaf(s[i], a, b);
+}
+
+__attribute__((target("avx2,fma")))
+static void affine_f64_avx2(double *d, const double *s, size_t n, double a, double b)
+{
+    const __m256d va = _mm256_set1_pd(a), vb = _mm256_set1_pd(b);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256d x0 = _mm256_loadu_pd(s + i), x1 = _mm256_loadu_pd(s + i + 4);
+        _mm256_storeu_pd(d + i,     _mm256_fmadd_pd(x0, va, vb));
+        _mm256_storeu_pd(d + i + 4, _mm256_fmadd_pd(x1, va, vb));
+    }
+    for (; i < n; ++i) d[i] = __builtin_fma(s[i], a, b);
+}
+
+__attribute__((target("avx2")))
+static void stream_copy_avx2(void *d, const void *s, size_t bytes)
+{
+    __m256i *dp = (__m256i *)d;
+    const __m256i *sp = (const __m256i *)s;
+    for (size_t i = 0; i < bytes / 32; i += 2)
+    {
+        __m256i x0 = _mm256_loadu_si256(sp + i), x1 = _mm256_loadu_si256(sp + i + 1);
+        _mm256_stream_si256(dp + i, x0);
+        _mm256_stream_si256(dp + i + 1, x1);
+    }
+    _mm_sfence();
+}
+
+__attribute__((target("avx2")))
+static void stream_fill_avx2(void *d, const unsigned char *pattern64, size_t bytes)
+{
+    __m256i *dp = (__m256i *)d;
+    const __m256i p0 = _mm256_loadu_si256((const __m256i *)pattern64);
+    const __m256i p1 = _mm256_loadu_si256((const __m256i *)(pattern64 + 32));
+    for (size_t i = 0; i < bytes / 32; i += 2)
+    {
+        _mm256_stream_si256(dp + i, p0);
+        _mm256_stream_si256(dp + i + 1, p1);
+    }
+    _mm_sfence();
+}
+
+__attribute__((target("avx512f")))
+static void affine_f32_avx512(float *d, const float *s, size_t n, float a, float b)
+{
+    const __m512 va = _mm512_set1_ps(a), vb = _mm512_set1_ps(b);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m512 x0 = _mm512_loadu_ps(s + i), x1 = _mm512_loadu_ps(s + i + 16);
+        _mm512_storeu_ps(d + i,      _mm512_fmadd_ps(x0, va, vb));
+        _mm512_storeu_ps(d + i + 16, _mm512_fmadd_ps(x1, va, vb));
+    }
+    for (; i < n; i += 16)
+    {
+        __mmask16 m = n - i >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << (n - i)) - 1);
+        _mm512_mask_storeu_ps(d + i, m, _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, s + i), va, vb));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void affine_f64_avx512(double *d, const double *s, size_t n, double a, double b)
+{
+    const __m512d va = _mm512_set1_pd(a), vb = _mm512_set1_pd(b);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512d x0 = _mm512_loadu_pd(s + i), x1 = _mm512_loadu_pd(s + i + 8);
+        _mm512_storeu_pd(d + i,     _mm512_fmadd_pd(x0, va, vb));
+        _mm512_storeu_pd(d + i + 8, _mm512_fmadd_pd(x1, va, vb));
+    }
+    for (; i < n; i += 8)
+    {
+        __mmask8 m = n - i >= 8 ? (__mmask8)0xff : (__mmask8)((1u << (n - i)) - 1);
+        _mm512_mask_storeu_pd(d + i, m, _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, s + i), va, vb));
+    }
+}
+
+/* VBMI: vpermi2b 한 번이 128 항목 표, 최상위 비트로 두 결과 중 하나를 고른다 */
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static void lut_u8_avx512vbmi(unsigned char *d, const unsigned char *s, size_t n, const unsigned char *lut)
+{
+    const __m512i t0 = _mm512_loadu_si512(lut),       t1 = _mm512_loadu_si512(lut + 64);
+    const __m512i t2 = _mm512_loadu_si512(lut + 128), t3 = _mm512_loadu_si512(lut + 192);
+    size_t i = 0;
+    for (; i < n; i += 64)
+    {
+        __mmask64 m = n - i >= 64 ? ~(__mmask64)0 : (((__mmask64)1 << (n - i)) - 1);
+        __m512i x  = _mm512_maskz_loadu_epi8(m, s + i);
+        __m512i lo = _mm512_permutex2var_epi8(t0, x, t1);
+        __m512i hi = _mm512_permutex2var_epi8(t2, x, t3);
+        __mmask64 top = _mm512_movepi8_mask(x);
+        _mm512_mask_storeu_epi8(d + i, m, _mm512_mask_blend_epi8(top, lo, hi));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void stream_copy_avx512(void *d, const void *s, size_t bytes)
+{
+    __m512i *dp = (__m512i *)d;
+    const __m512i *sp = (const __m512i *)s;
+    for (size_t i = 0; i < bytes / 64; ++i) _mm512_stream_si512(dp + i, _mm512_loadu_si512(sp + i));
+    _mm_sfence();
+}
+
+__attribute__((target("avx512f")))
+static void stream_fill_avx512(void *d, const unsigned char *pattern64, size_t bytes)
+{
+    __m512i *dp = (__m512i *)d;
+    const __m512i p = _mm512_loadu_si512(pattern64);
+    for (size_t i = 0; i < bytes / 64; ++i) _mm512_stream_si512(dp + i, p);
+    _mm_sfence();
+}
+#endif /* ARRAY_X86 */
+
+#if defined(ARRAY_NEON)
+static void affine_f32_neon(float *d, const float *s, size_t n, float a, float b)
+{
+    const float32x4_t vb = vdupq_n_f32(b);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        vst1q_f32(d + i,     vfmaq_n_f32(vb, vld1q_f32(s + i), a));
+        vst1q_f32(d + i + 4, vfmaq_n_f32(vb, vld1q_f32(s + i + 4), a));
+    }
+    for (; i < n; ++i) d[i] = __builtin_fmaf(s[i], a, b);
+}
+
+static void affine_f64_neon(double *d, const double *s, size_t n, double a, double b)
+{
+    const float64x2_t vb = vdupq_n_f64(b);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        vst1q_f64(d + i,     vfmaq_n_f64(vb, vld1q_f64(s + i), a));
+        vst1q_f64(d + i + 2, vfmaq_n_f64(vb, vld1q_f64(s + i + 2), a));
+    }
+    for (; i < n; ++i) d[i] = __builtin_fma(s[i], a, b);
+}
+
+/* tbl4 가 64 항목 표: 네 번 (tbx 는 범위 밖이면 이전 값을 둔다) */
+static void lut_u8_neon(unsigned char *d, const unsigned char *s, size_t n, const unsigned char *lut)
+{
+    uint8x16x4_t t0 = vld1q_u8_x4(lut),       t1 = vld1q_u8_x4(lut + 64);
+    uint8x16x4_t t2 = vld1q_u8_x4(lut + 128), t3 = vld1q_u8_x4(lut + 192);
+    const uint8x16_t k64 = vdupq_n_u8(64);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16_t x = vld1q_u8(s + i);
+        uint8x16_t r = vqtbl4q_u8(t0, x);
+        x = vsubq_u8(x, k64); r = vqtbx4q_u8(r, t1, x);
+        x = vsubq_u8(x, k64); r = vqtbx4q_u8(r, t2, x);
+        x = vsubq_u8(x, k64); r = vqtbx4q_u8(r, t3, x);
+        vst1q_u8(d + i, r);
+    }
+    lut_u8_scalar(d + i, s + i, n - i, lut);
+}
+#endif /* ARRAY_NEON */
+
+enum { ISA_SCALAR, ISA_SIMD, ISA_SIMD512 };
+
+static array_ops ops;
+static pthread_once_t ops_once = PTHREAD_ONCE_INIT;
+
+static void ops_init(void)
+{
+    int cap = ISA_SIMD512;
+    const char *env = getenv("PARALLEL_ISA");
+    if (env && (!strcmp(env, "scalar")))                         cap = ISA_SCALAR;
+    else if (env && (!strcmp(env, "avx2") || !strcmp(env, "neon"))) cap = ISA_SIMD;
+
+    ops = (array_ops)
+    {
+        .name = "scalar",
+        .affine_f32 = affine_f32_scalar, .affine_f64 = affine_f64_scalar, .lut_u8 = lut_u8_scalar,
+    };
+#if defined(ARRAY_X86)
+    __builtin_cpu_init();
+    if (cap >= ISA_SIMD && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        ops.name = "avx2";
+        ops.affine_f32 = affine_f32_avx2;
+        ops.affine_f64 = affine_f64_avx2;
+        ops.stream_copy = stream_copy_avx2;
+        ops.stream_fill = stream_fill_avx2;
+    }
+    if (cap >= ISA_SIMD512 && __builtin_cpu_supports("avx512f"))
+    {
+        ops.name = "avx512";
+        ops.affine_f32 = affine_f32_avx512;
+        ops.affine_f64 = affine_f64_avx512;
+        ops.stream_copy = stream_copy_avx512;
+        ops.stream_fill = stream_fill_avx512;
+        if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vbmi"))
+            ops.lut_u8 = lut_u8_avx512vbmi;
+    }
+#elif defined(ARRAY_NEON)
+    if (cap >= ISA_SIMD)
+    {
+        ops.name = "neon";
+        ops.affine_f32 = affine_f32_neon;
+        ops.affine_f64 = affine_f64_neon;
+        ops.lut_u8 = lut_u8_neon;
+    }
+#else
+    (void)cap;
+#endif
+}
+
+static const array_ops *get_ops(void)
+{
+    pthread_once(&ops_once, ops_init);
+    return &ops;
+}
+
+const char *parallel_array_isa(void)
+{
+    return get_ops()->name;
+}
+
+/* ---- 타일 분할 ----
+ * 타일 0 은 dst 가 64B 경계에 닿을 때까지의 머리, 그 뒤는 경계에서 시작하는 TILE_BYTES 씩.
+ * 워커마다 캐시라인을 나눠 쓰지 않고, non-temporal store 는 정렬된 주소에서 시작한다 */
+typedef void (*tile_fn)(void *ctx, size_t lo, size_t hi);
+
+typedef struct
+{
+    size_t n, head, tile;
+    tile_fn fn;
+    void *ctx;
+} tiling;
+
+static void tile_range(long start, long stop, void *arg)
+{
+    const tiling *t = (const tiling *)arg;
+    for (long k = start; k < stop; ++k)
+    {
+        size_t lo = k ? t->head + (size_t)(k - 1) * t->tile : 0;
+        size_t hi = t->head + (size_t)k * t->tile;
+        if (hi > t->n) hi = t->n;
+        if (lo < hi) t->fn(t->ctx, lo, hi);
+    }
+}
+
+static int run_tiled(parallel_pool *pool, const void *dst, size_t esize, size_t n, int options,
+                     tile_fn fn, void *ctx)
+{
+    if (n == 0) return 0;
+    size_t mis = (uintptr_t)dst & 63;
+    size_t head = mis && mis % esize == 0 ? (64 - mis) / esize : 0;
+    if (head > n) head = n;
+    size_t tile = PARALLEL_ARRAY_TILE_BYTES / esize;
+    if (tile == 0) tile = 1;
+    tiling t = { .n=n, .head=head, .tile=tile, .fn=fn, .ctx=ctx };
+    long ntiles = 1 + (long)((n - head + tile - 1) / tile);
+    if (pool) return parallel_pool_for_range(pool, 0, ntiles, 1, options, tile_range, &t);
+    return parallel_for_range(0, ntiles, 1, 0, options, tile_range, &t);
+}
+
+/* ---- 사용자 커널 ---- */
+enum { XFORM_F32, XFORM_F64, XFORM_U8 };
+
+/* fn 은 제 타입 그대로 들고 있다가 타일마다 type 으로 골라 부른다 */
+typedef struct
+{
+    int type;
+    union
+    {
+        ptransform_f32_fn f32;
+        ptransform_f64_fn f64;
+        ptransform_u8_fn u8;
+    } fn;
+    void *dst;
+    const void *src;
+    void *userdata;
+} xform_ctx;
+
+static void xform_tile(void *arg, size_t lo, size_t hi)
+{
+    const xform_ctx *c = (const xform_ctx *)arg;
+    switch (c->type)
+    {
+        case XFORM_F32:
+            c->fn.f32((float *)c->dst + lo, (const float *)c->src + lo, hi - lo, c->userdata);
+            break;
+        case XFORM_F64:
+            c->fn.f64((double *)c->dst + lo, (const double *)c->src + lo, hi - lo, c->userdata);
+            break;
+        default:
+            c->fn.u8((unsigned char *)c->dst + lo, (const unsigned char *)c->src + lo, hi - lo, c->userdata);
+            break;
+    }
+}
+
+static int transform(parallel_pool *pool, size_t esize, size_t n, xform_ctx *c, int options)
+{
+    if (!c->dst || !c->src) return -1;
+    return run_tiled(pool, c->dst, esize, n, options, xform_tile, c);
+}
+
+int parallel_transform_f32(parallel_pool *pool, float *dst, const float *src, size_t n,
+                           ptransform_f32_fn fn, void *userdata, int options)
+{
+    if (!fn) return -1;
+    xform_ctx c = { .type=XFORM_F32, .fn.f32=fn, .dst=dst, .src=src, .userdata=userdata };
+    return transform(pool, sizeof(float), n, &c, options);
+}
+
+int parallel_transform_f64(parallel_pool *pool, double *dst, const double *src, size_t n,
+                           ptransform_f64_fn fn, void *userdata, int options)
+{
+    if (!fn) return -1;
+    xform_ctx c = { .type=XFORM_F64, .fn.f64=fn, .dst=dst, .src=src, .userdata=userdata };
+    return transform(pool, sizeof(double), n, &c, options);
+}
+
+int parallel_transform_u8(parallel_pool *pool, unsigned char *dst, const unsigned char *src, size_t n,
+                          ptransform_u8_fn fn, void *userdata, int options)
+{
+    if (!fn) return -1;
+    xform_ctx c = { .type=XFORM_U8, .fn.u8=fn, .dst=dst, .src=src, .userdata=userdata };
+    return transform(pool, 1, n, &c, options);
+}
+
+/* ---- 내장 커널 ---- */
+typedef struct
+{
+    const array_ops *ops;
+    void *dst;
+    const void *src;
+    double a, b;
+    const unsigned char *lut;
+} builtin_ctx;
+
+static void affine_f32_tile(void *arg, size_t lo, size_t hi)
+{
+    const builtin_ctx *c = (const builtin_ctx *)arg;
+    c->ops->affine_f32((float *)c->dst + lo, (const float *)c->src + lo, hi - lo, (float)c->a, (float)c->b);
+}
+
+static void affine_f64_tile(void *arg, size_t lo, size_t hi)
+{
+    const builtin_ctx *c = (const builtin_ctx *)arg;
+    c->ops->affine_f64((double *)c->dst + lo, (const double *)c->src + lo, hi - lo, c->a, c->b);
+}
+
+static void lut_u8_tile(void *arg, size_t lo, size_t hi)
+{
+    const builtin_ctx *c = (const builtin_ctx *)arg;
+    c->ops->lut_u8((unsigned char *)c->dst + lo, (const unsigned char *)c->src + lo, hi - lo, c->lut);
+}
+
+int parallel_affine_f32(parallel_pool *pool, float *dst, const float *src, size_t n,
+                        float a, float b, int options)
+{
+    if (!dst || !src) return -1;
+    builtin_ctx c = { .ops=get_ops(), .dst=dst, .src=src, .a=a, .b=b };
+    return run_tiled(pool, dst, sizeof(float), n, options, affine_f32_tile, &c);
+}
+
+int parallel_affine_f64(parallel_pool *pool, double *dst, const double *src, size_t n,
+                        double a, double b, int options)
+{
+    if (!dst || !src) return -1;
+    builtin_ctx c = { .ops=get_ops(), .dst=dst, .src=src, .a=a, .b=b };
+    return run_tiled(pool, dst, sizeof(double), n, options, affine_f64_tile, &c);
+}
+
+int parallel_lut_u8(parallel_pool *pool, unsigned char *dst, const unsigned char *src, size_t n,
+                    const unsigned char lut[256], int options)
+{
+    if (!dst || !src || !lut) return -1;
+    builtin_ctx c = { .ops=get_ops(), .dst=dst, .src=src, .lut=lut };
+    return run_tiled(pool, dst, 1, n, options, lut_u8_tile, &c);
+}
+
+/* ---- fill / copy: 타일 안은 libc (이미 ISA 별) 또는 큰 배열이면 non-temporal ---- */
+typedef struct
+{
+    unsigned char *dst;
+    const unsigned char *src;
+    size_t esize;
+    unsigned char pattern[64];      // fill (non-temporal): 값을 64B 로 반복
+    void (*stream_copy)(void *, const void *, size_t);
+    void (*stream_fill)(void *, const unsigned char *, size_t);
+} bulk_ctx;
+
+static void copy_tile(void *arg, size_t lo, size_t hi)
+{
+    const bulk_ctx *c = (const bulk_ctx *)arg;
+    unsigned char *d = c->dst + lo;
+    const unsigned char *s = c->src + lo;
+    size_t n = hi - lo, body = n & ~(size_t)63;
+    // 타일 0 말고는 d 가 64B 정렬
+    if (c->stream_copy && body && ((uintptr_t)d & 63) == 0)
+    {
+        c->stream_copy(d, s, body);
+        memcpy(d + body, s + body, n - body);
+        return;
+    }
+    memcpy(d, s, n);
+}
+
+static void fill_tile(void *arg, size_t lo, size_t hi)
+{
+    const bulk_ctx *c = (const bulk_ctx *)arg;
+    unsigned char *d = c->dst + lo * c->esize;
+    size_t bytes = (hi - lo) * c->esize, done;
+    if (c->stream_fill && ((uintptr_t)d & 63) == 0)
+    {
+        done = bytes & ~(size_t)63;
+        c->stream_fill(d, c->pattern, done);
+        for (; done < bytes; ++done) d[done] = c->pattern[done & 63];
+        return;
+    }
+    if (c->esize == 1) { memset(d, c->src[0], bytes); return; }
+    // 원소 하나를 놓고 이미 채운 앞부분을 두 배씩 복사
+    memcpy(d, c->src, c->esize);
+    for (done = c->esize; done < bytes; )
+    {
+        size_t k = done < bytes - done ? done : bytes - done;
+        memcpy(d + done, d, k);
+        done += k;
+    }
+}
+
+int parallel_fill(parallel_pool *pool, void *dst, const void *value, size_t elem_size, size_t n,
+                  int options)
+{
+    if (!dst || !value || !elem_size) return -1;
+    bulk_ctx c = { .dst=(unsigned char *)dst, .src=(const unsigned char *)value, .esize=elem_size };
+    // 64B 를 나누는 원소만 non-temporal (패턴 하나로 어느 정렬 위치든 채운다)
+    if (64 % elem_size == 0 && elem_size * n >= (size_t)PARALLEL_ARRAY_NT_BYTES)
+    {
+        for (size_t i = 0; i < 64; i += elem_size) memcpy(c.pattern + i, value, elem_size);
+        c.stream_fill = get_ops()->stream_fill;
+    }
+    return run_tiled(pool, dst, elem_size, n, options, fill_tile, &c);
+}
+
+int parallel_copy(parallel_pool *pool, void *dst, const void *src, size_t bytes, int options)
+{
+    if (!dst || !src) return -1;
+    bulk_ctx c = { .dst=(unsigned char *)dst, .src=(const unsigned char *)src, .esize=1 };
+    if (bytes >= (size_t)PARALLEL_ARRAY_NT_BYTES) c.stream_copy = get_ops()->stream_copy;
+    return run_tiled(pool, dst, 1, bytes, options, copy_tile, &c);
+}
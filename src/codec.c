@@ -0,0 +1,407 @@
+/* codec.c — 코덱 백엔드. bzip2 와 gzip 은 항상, zstd / lz4 는 HAVE_ZSTD / HAVE_LZ4 로 빌드 */
+#include "codec.h"
+#include <bzlib.h>
+#include <zlib.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_ZSTD
+#  include <zstd.h>
+#endif
+#ifdef HAVE_LZ4
+#  include <lz4frame.h>
+#endif
+
+/* 한 번의 호출로 넘길 수 있는 길이 (bzip2 / zlib 은 unsigned int) */
+static unsigned int clamp_uint(size_t n)
+{
+    return n > UINT_MAX ? UINT_MAX : (unsigned int)n;
+}
+
+/* ---- bzip2 ---- */
+
+/* 워커별 bzip2 할당 캐시: Init/End 마다 수 MB를 malloc/free 하지 않도록
+ * 해제된 버퍼를 크기별로 보관했다가 다음 블록에서 재사용한다 */
+#define SCRATCH_SLOTS 8
+typedef struct
+{
+    void  *ptr[SCRATCH_SLOTS];
+    size_t size[SCRATCH_SLOTS];
+    int    used[SCRATCH_SLOTS];
+} Scratch;
+
+static void *scratch_alloc(void *opaque, int items, int size)
+{
+    Scratch *s = (Scratch *)opaque;
+    size_t n = (size_t)items * (size_t)size;
+    int empty = -1;
+    for (int i = 0; i < SCRATCH_SLOTS; ++i)
+    {
+        if (s->ptr[i] && !s->used[i] && s->size[i] == n) { s->used[i] = 1; return s->ptr[i]; }
+        if (!s->ptr[i] && empty < 0) empty = i;
+    }
+    void *p = malloc(n);
+    if (p && empty >= 0) { s->ptr[empty] = p; s->size[empty] = n; s->used[empty] = 1; }
+    return p;
+}
+
+static void scratch_free(void *opaque, void *p)
+{
+    Scratch *s = (Scratch *)opaque;
+    for (int i = 0; i < SCRATCH_SLOTS; ++i)
+    {
+        if (s->ptr[i] == p) { s->used[i] = 0; return; }
+    }
+    free(p);
+}
+
+typedef struct
+{
+    Scratch scratch;
+    int level;
+    bz_stream dec;
+    int dec_active;
+} bz_ctx;
+
+static void bz_setup(bz_ctx *c, bz_stream *strm)
+{
+    memset(strm, 0, sizeof(*strm));
+    strm->bzalloc = scratch_alloc;
+    strm->bzfree  = scratch_free;
+    strm->opaque  = &c->scratch;
+}
+
+static void *bz_init(int level)
+{
+    bz_ctx *c = (bz_ctx *)calloc(1, sizeof(bz_ctx));
+    if (c) c->level = level;
+    return c;
+}
+
+static size_t bz_bound(size_t len) { return len + len / 100 + 1000; }
+
+/* 한 블록 = 하나의 .bz2 스트림, 한 번에 FINISH */
+static int bz_compress(void *ctx, const unsigned char *src, size_t src_len,
+                       unsigned char *dst, size_t dst_cap, size_t *dst_len)
+{
+    bz_ctx *c = (bz_ctx *)ctx;
+    bz_stream strm;
+    bz_setup(c, &strm);
+    if (BZ2_bzCompressInit(&strm, c->level, 0, 30) != BZ_OK) return -1;   // verbosity=0, workFactor=30(기본)
+    strm.next_in   = (char *)src;
+    strm.avail_in  = clamp_uint(src_len);
+    strm.next_out  = (char *)dst;
+    strm.avail_out = clamp_uint(dst_cap);
+    int rc = BZ2_bzCompress(&strm, BZ_FINISH);
+    *dst_len = (size_t)((unsigned char *)strm.next_out - dst);
+    BZ2_bzCompressEnd(&strm);
+    return rc == BZ_STREAM_END && strm.avail_in == 0 ? 0 : -1;
+}
+
+static int bz_decode_begin(void *ctx)
+{
+    bz_ctx *c = (bz_ctx *)ctx;
+    if (c->dec_active) BZ2_bzDecompressEnd(&c->dec);
+    bz_setup(c, &c->dec);
+    c->dec_active = BZ2_bzDecompressInit(&c->dec, 0, 0) == BZ_OK;
+    return c->dec_active ? 0 : -1;
+}
+
+static int bz_decode(void *ctx, const unsigned char *src, size_t src_len, size_t *src_used,
+                     unsigned char *dst, size_t dst_cap, size_t *dst_used)
+{
+    bz_ctx *c = (bz_ctx *)ctx;
+    if (!c->dec_active) return CODEC_ERROR;
+    c->dec.next_in   = (char *)src;
+    c->dec.avail_in  = clamp_uint(src_len);
+    c->dec.next_out  = (char *)dst;
+    c->dec.avail_out = clamp_uint(dst_cap);
+    int rc = BZ2_bzDecompress(&c->dec);
+    *src_used = (size_t)((const unsigned char *)c->dec.next_in - src);
+    *dst_used = (size_t)((unsigned char *)c->dec.next_out - dst);
+    if (rc == BZ_OK) return CODEC_MORE;
+    BZ2_bzDecompressEnd(&c->dec);
+    c->dec_active = 0;
+    return rc == BZ_STREAM_END ? CODEC_FRAME_END : CODEC_ERROR;
+}
+
+static void bz_end(void *ctx)
+{
+    bz_ctx *c = (bz_ctx *)ctx;
+    if (!c) return;
+    if (c->dec_active) BZ2_bzDecompressEnd(&c->dec);
+    for (int i = 0; i < SCRATCH_SLOTS; ++i) free(c->scratch.ptr[i]);
+    free(c);
+}
+
+/* 스트림 헤더 "BZh[1-9]" 바로 뒤에 첫 블록 매직(pi)이 온다 */
+static int bz_frame_start(const unsigned char *p, size_t n)
+{
+    static const unsigned char blk_magic[6] = { 0x31, 0x41, 0x59, 0x26, 0x53, 0x59 };
+    return n >= 10 && p[0] == 'B' && p[1] == 'Z' && p[2] == 'h' && p[3] >= '1' && p[3] <= '9' &&
+           memcmp(p + 4, blk_magic, sizeof(blk_magic)) == 0;
+}
+
+/* ---- gzip (zlib, 블록마다 gzip 멤버 하나) ---- */
+
+typedef struct
+{
+    z_stream enc, dec;
+    int enc_ok, dec_ok;
+    int level;
+} gz_ctx;
+
+static void *gz_init(int level)
+{
+    gz_ctx *c = (gz_ctx *)calloc(1, sizeof(gz_ctx));
+    if (c) c->level = level;
+    return c;
+}
+
+/* zlib 래퍼(6) 대신 gzip 헤더+트레일러(18) */
+static size_t gz_bound(size_t len) { return compressBound((uLong)len) + 18; }
+
+static int gz_compress(void *ctx, const unsigned char *src, size_t src_len,
+                       unsigned char *dst, size_t dst_cap, size_t *dst_len)
+{
+    gz_ctx *c = (gz_ctx *)ctx;
+    // deflate 상태(~256KB)는 한 번만 만들고 블록마다 reset
+    if (!c->enc_ok)
+        c->enc_ok = deflateInit2(&c->enc, c->level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    else if (deflateReset(&c->enc) != Z_OK)
+        return -1;
+    if (!c->enc_ok) return -1;
+    c->enc.next_in   = (Bytef *)src;
+    c->enc.avail_in  = clamp_uint(src_len);
+    c->enc.next_out  = dst;
+    c->enc.avail_out = clamp_uint(dst_cap);
+    int rc = deflate(&c->enc, Z_FINISH);
+    *dst_len = (size_t)(c->enc.next_out - dst);
+    return rc == Z_STREAM_END && c->enc.avail_in == 0 ? 0 : -1;
+}
+
+static int gz_decode_begin(void *ctx)
+{
+    gz_ctx *c = (gz_ctx *)ctx;
+    if (!c->dec_ok) c->dec_ok = inflateInit2(&c->dec, 15 + 16) == Z_OK;
+    else if (inflateReset(&c->dec) != Z_OK) return -1;
+    return c->dec_ok ? 0 : -1;
+}
+
+static int gz_decode(void *ctx, const unsigned char *src, size_t src_len, size_t *src_used,
+                     unsigned char *dst, size_t dst_cap, size_t *dst_used)
+{
+    gz_ctx *c = (gz_ctx *)ctx;
+    c->dec.next_in   = (Bytef *)src;
+    c->dec.avail_in  = clamp_uint(src_len);
+    c->dec.next_out  = dst;
+    c->dec.avail_out = clamp_uint(dst_cap);
+    int rc = inflate(&c->dec, Z_NO_FLUSH);
+    *src_used = (size_t)(c->dec.next_in - src);
+    *dst_used = (size_t)(c->dec.next_out - dst);
+    if (rc == Z_STREAM_END) return CODEC_FRAME_END;
+    return rc == Z_OK || rc == Z_BUF_ERROR ? CODEC_MORE : CODEC_ERROR;   // BUF_ERROR = 진행 불가, 호출자가 판단
+}
+
+static void gz_end(void *ctx)
+{
+    gz_ctx *c = (gz_ctx *)ctx;
+    if (!c) return;
+    if (c->enc_ok) deflateEnd(&c->enc);
+    if (c->dec_ok) inflateEnd(&c->dec);
+    free(c);
+}
+
+/* zlib 이 쓰는 헤더: 1f 8b, deflate, FLG=0, MTIME=0. 남이 만든 gzip 은 통째로 한 구간이 된다 */
+static int gz_frame_start(const unsigned char *p, size_t n)
+{
+    return n >= 10 && p[0] == 0x1f && p[1] == 0x8b && p[2] == 8 && p[3] == 0 &&
+           p[4] == 0 && p[5] == 0 && p[6] == 0 && p[7] == 0 && (p[8] == 0 || p[8] == 2 || p[8] == 4);
+}
+
+/* ---- zstd ---- */
+#ifdef HAVE_ZSTD
+typedef struct
+{
+    ZSTD_CCtx *cctx;
+    ZSTD_DCtx *dctx;
+    int level;
+} zs_ctx;
+
+static void *zs_init(int level)
+{
+    zs_ctx *c = (zs_ctx *)calloc(1, sizeof(zs_ctx));
+    if (c) c->level = level;
+    return c;
+}
+
+static size_t zs_bound(size_t len) { return ZSTD_compressBound(len); }
+
+static int zs_compress(void *ctx, const unsigned char *src, size_t src_len,
+                       unsigned char *dst, size_t dst_cap, size_t *dst_len)
+{
+    zs_ctx *c = (zs_ctx *)ctx;
+    if (!c->cctx && !(c->cctx = ZSTD_createCCtx())) return -1;
+    size_t r = ZSTD_compressCCtx(c->cctx, dst, dst_cap, src, src_len, c->level);
+    if (ZSTD_isError(r)) return -1;
+    *dst_len = r;
+    return 0;
+}
+
+static int zs_decode_begin(void *ctx)
+{
+    zs_ctx *c = (zs_ctx *)ctx;
+    if (!c->dctx) return (c->dctx = ZSTD_createDCtx()) ? 0 : -1;
+    return ZSTD_isError(ZSTD_DCtx_reset(c->dctx, ZSTD_reset_session_only)) ? -1 : 0;
+}
+
+static int zs_decode(void *ctx, const unsigned char *src, size_t src_len, size_t *src_used,
+                     unsigned char *dst, size_t dst_cap, size_t *dst_used)
+{
+    zs_ctx *c = (zs_ctx *)ctx;
+    ZSTD_inBuffer  in  = { src, src_len, 0 };
+    ZSTD_outBuffer out = { dst, dst_cap, 0 };
+    size_t r = ZSTD_decompressStream(c->dctx, &out, &in);   // 프레임 끝에서 멈춘다
+    *src_used = in.pos;
+    *dst_used = out.pos;
+    if (ZSTD_isError(r)) return CODEC_ERROR;
+    return r == 0 ? CODEC_FRAME_END : CODEC_MORE;
+}
+
+static void zs_end(void *ctx)
+{
+    zs_ctx *c = (zs_ctx *)ctx;
+    if (!c) return;
+    ZSTD_freeCCtx(c->cctx);
+    ZSTD_freeDCtx(c->dctx);
+    free(c);
+}
+
+/* 매직 28 b5 2f fd, 프레임 헤더 서술자의 reserved 비트(3)는 0 */
+static int zs_frame_start(const unsigned char *p, size_t n)
+{
+    return n >= 5 && p[0] == 0x28 && p[1] == 0xb5 && p[2] == 0x2f && p[3] == 0xfd && !(p[4] & 0x08);
+}
+#endif
+
+/* ---- lz4 (frame 포맷) ---- */
+#ifdef HAVE_LZ4
+typedef struct
+{
+    LZ4F_cctx *cctx;
+    LZ4F_dctx *dctx;
+    int level;
+} lz_ctx;
+
+static void *lz_init(int level)
+{
+    lz_ctx *c = (lz_ctx *)calloc(1, sizeof(lz_ctx));
+    if (c) c->level = level;
+    return c;
+}
+
+static size_t lz_bound(size_t len) { return LZ4F_compressFrameBound(len, NULL); }
+
+static int lz_compress(void *ctx, const unsigned char *src, size_t src_len,
+                       unsigned char *dst, size_t dst_cap, size_t *dst_len)
+{
+    lz_ctx *c = (lz_ctx *)ctx;
+    if (!c->cctx && LZ4F_isError(LZ4F_createCompressionContext(&c->cctx, LZ4F_VERSION))) { c->cctx = NULL; return -1; }
+    LZ4F_preferences_t prefs;
+    memset(&prefs, 0, sizeof(prefs));
+    prefs.compressionLevel = c->level;
+    prefs.frameInfo.contentSize = src_len;          // 헤더에 원본 크기 기록
+    prefs.autoFlush = 1;                            // compressFrameBound 와 같은 가정
+    size_t pos = LZ4F_compressBegin(c->cctx, dst, dst_cap, &prefs);
+    if (LZ4F_isError(pos)) return -1;
+    size_t r = LZ4F_compressUpdate(c->cctx, dst + pos, dst_cap - pos, src, src_len, NULL);
+    if (LZ4F_isError(r)) return -1;
+    pos += r;
+    r = LZ4F_compressEnd(c->cctx, dst + pos, dst_cap - pos, NULL);
+    if (LZ4F_isError(r)) return -1;
+    *dst_len = pos + r;
+    return 0;
+}
+
+static int lz_decode_begin(void *ctx)
+{
+    lz_ctx *c = (lz_ctx *)ctx;
+    if (!c->dctx)
+    {
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&c->dctx, LZ4F_VERSION))) { c->dctx = NULL; return -1; }
+        return 0;
+    }
+    LZ4F_resetDecompressionContext(c->dctx);
+    return 0;
+}
+
+static int lz_decode(void *ctx, const unsigned char *src, size_t src_len, size_t *src_used,
+                     unsigned char *dst, size_t dst_cap, size_t *dst_used)
+{
+    lz_ctx *c = (lz_ctx *)ctx;
+    size_t in = src_len, out = dst_cap;
+    size_t r = LZ4F_decompress(c->dctx, dst, &out, src, &in, NULL);
+    *src_used = in;
+    *dst_used = out;
+    if (LZ4F_isError(r)) return CODEC_ERROR;
+    return r == 0 ? CODEC_FRAME_END : CODEC_MORE;
+}
+
+static void lz_end(void *ctx)
+{
+    lz_ctx *c = (lz_ctx *)ctx;
+    if (!c) return;
+    if (c->cctx) LZ4F_freeCompressionContext(c->cctx);
+    if (c->dctx) LZ4F_freeDecompressionContext(c->dctx);
+    free(c);
+}
+
+/* 매직 04 22 4d 18, FLG 의 버전 비트(7-6)는 01 */
+static int lz_frame_start(const unsigned char *p, size_t n)
+{
+    return n >= 5 && p[0] == 0x04 && p[1] == 0x22 && p[2] == 0x4d && p[3] == 0x18 && (p[4] >> 6) == 1;
+}
+#endif
+
+static const codec codecs[] = {
+    { "bzip2", ".bz2", 1, 9, 9, bz_init, bz_bound, bz_compress, bz_decode_begin, bz_decode, bz_end,
+      bz_frame_start, 10, { 'B', 'Z', 'h' }, 3 },
+    { "gzip", ".gz", 1, 9, 6, gz_init, gz_bound, gz_compress, gz_decode_begin, gz_decode, gz_end,
+      gz_frame_start, 10, { 0x1f, 0x8b, 0x08 }, 3 },
+#ifdef HAVE_ZSTD
+    { "zstd", ".zst", 1, 19, 3, zs_init, zs_bound, zs_compress, zs_decode_begin, zs_decode, zs_end,
+      zs_frame_start, 5, { 0x28, 0xb5, 0x2f, 0xfd }, 4 },
+#endif
+#ifdef HAVE_LZ4
+    { "lz4", ".lz4", 1, 12, 1, lz_init, lz_bound, lz_compress, lz_decode_begin, lz_decode, lz_end,
+      lz_frame_start, 5, { 0x04, 0x22, 0x4d, 0x18 }, 4 },
+#endif
+};
+
+#define NCODECS (sizeof(codecs) / sizeof(codecs[0]))
+
+const codec *codec_find(const char *name)
+{
+    for (size_t i = 0; i < NCODECS; ++i)
+        if (!strcmp(codecs[i].name, name)) return &codecs[i];
+    return NULL;
+}
+
+const codec *codec_detect(const unsigned char *p, size_t n)
+{
+    for (size_t i = 0; i < NCODECS; ++i)
+        if (n >= codecs[i].magic_len && !memcmp(p, codecs[i].magic, codecs[i].magic_len)) return &codecs[i];
+    return NULL;
+}
+
+const char *codec_names(void)
+{
+    return "bzip2 gzip"
+#ifdef HAVE_ZSTD
+           " zstd"
+#endif
+#ifdef HAVE_LZ4
+           " lz4"
+#endif
+        ;
+}
@@ -0,0 +1,48 @@
+/* codec.h — 블록 압축기용 코덱 vtable (bzip2 / gzip / zstd / lz4) */
+#pragma once
+#include <stddef.h>
+
+/* decode 반환값 */
+enum
+{
+    CODEC_ERROR     = -1,
+    CODEC_MORE      = 0,    // 입력이나 출력 공간이 더 필요
+    CODEC_FRAME_END = 1,    // 프레임 하나를 끝까지 풀었다
+};
+
+/* 블록 하나 = 독립된 프레임 하나. 프레임을 이어 붙인 파일은 각 포맷의 표준 도구로도 풀린다.
+ * ctx 는 워커마다 하나 (init 에서 만들고 end 에서 해제), 스레드 간에 공유하지 않는다. */
+typedef struct codec
+{
+    const char *name;
+    const char *suffix;                         // ".bz2", ".gz", ...
+    int level_min, level_max, level_default;
+
+    void  *(*init)(int level);                  // 실패 시 NULL
+    size_t (*bound)(size_t len);                // len 바이트 블록의 최악 압축 크기
+    /* src 전체를 프레임 하나로 압축. 성공 0, 실패 -1 */
+    int    (*compress)(void *ctx, const unsigned char *src, size_t src_len,
+                       unsigned char *dst, size_t dst_cap, size_t *dst_len);
+    /* 프레임 하나 해제 시작. 성공 0, 실패 -1 */
+    int    (*decode_begin)(void *ctx);
+    /* 진행한 만큼 *src_used / *dst_used 를 채운다. CODEC_* 반환 */
+    int    (*decode)(void *ctx, const unsigned char *src, size_t src_len, size_t *src_used,
+                     unsigned char *dst, size_t dst_cap, size_t *dst_used);
+    void   (*end)(void *ctx);
+
+    /* p 가 이 코덱으로 쓴 블록 프레임 헤더로 시작하면 1. 병렬 해제의 경계 탐색용이라
+     * 우연한 일치를 줄이도록 엄격하다 */
+    int    (*frame_start)(const unsigned char *p, size_t n);
+    size_t frame_hdr;                           // frame_start 가 보는 최소 바이트 수
+    unsigned char magic[4];                     // 포맷 매직 (형식 판별, magic[0] 은 memchr 용)
+    size_t magic_len;
+} codec;
+
+/* 이름으로 찾기 ("bzip2", "gzip", "zstd", "lz4"). 빌드에 없으면 NULL */
+const codec *codec_find(const char *name);
+
+/* 데이터 앞의 포맷 매직으로 코덱 판별 (다른 도구가 만든 파일도). 모르면 NULL */
+const codec *codec_detect(const unsigned char *p, size_t n);
+
+/* 빌드에 포함된 코덱 이름들, 공백 구분 (usage 용) */
+const char *codec_names(void);
@@ -1,14 +1,21 @@
 /* parallel.c */
 #define _GNU_SOURCE
 #include "parallel.h"
+#include "topology.h"
 #include <pthread.h>
 #include <sched.h>
 #include <unistd.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
+#include <linux/futex.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
 
 #if !defined(__has_attribute)
 #  define __has_attribute(x) 0
@@ -20,17 +27,139 @@
 #  define UNLIKELY(x) __builtin_expect(!!(x), 0)
 #endif
 
+/* ADAPTIVE 모드에서 청크 하나가 목표로 하는 실행 시간 */
+#ifndef PARALLEL_ADAPTIVE_TARGET_NS
+#  define PARALLEL_ADAPTIVE_TARGET_NS 50000L
+#endif
+
+
+typedef struct pfor_job pfor_job;
+
+enum { JOB_LOOP, JOB_TASKS };
+
+typedef struct ptask
+{
+    ptask_fn fn;
+    void *arg;
+    struct ptask *next;
+} ptask;
+
+/* work-stealing: owner는 앞(lo)에서 chunk씩, thief는 뒤 절반을 가져간다 */
+typedef struct
+{
+    volatile int lock;
+    long lo, hi;
+} __attribute__((aligned(64))) steal_range;
 
+/* PARALLEL_OPT_STATS: 워커 (슬롯) 마다 하나, 서로 다른 캐시라인 */
 typedef struct
 {
+    parallel_worker_stats s;
+} __attribute__((aligned(64))) stat_slot;
+
+/* 한 번의 parallel_for 호출, 또는 태스크 그룹 하나 */
+struct pfor_job
+{
+    volatile long next __attribute__((aligned(64)));   // shared counter는 자기 캐시라인에
     long begin, end, chunk;
-    volatile long *next;
+    pfor_range_fn fn;
+    void *userdata;
+    int flags;
+    steal_range *ranges;    // SCHED_STEAL / SCHED_STATIC: 워커당 하나
+    int nranges;
+    int nthreads;
+    int kind;           // JOB_LOOP / JOB_TASKS
+    int depth;          // 중첩 깊이: 밖에서 제출 0, 워커 안에서 제출하면 그 워커의 깊이 + 1
+    int cancelled;      // 남은 청크를 버렸다: 워커는 다음 청크 경계에서 멈춘다
+    int has_sched;      // 워커가 이 job 동안 sched 로 돈다
+    parallel_sched sched;
+    stat_slot *stats;   // 통계를 켰을 때 nthreads + 1 개, 아니면 NULL
+    long t_submit, t_done;
+    int refs;           // 참여 중인 워커 수      (pool->lock)
+    int exhausted;      // 더 나눠줄 청크 없음, 큐에서 빠짐 (pool->lock)
+    int done;           // exhausted && refs == 0 (pool->lock)
+    ptask *tasks, *tasks_tail;  // JOB_TASKS: 아직 아무도 가져가지 않은 태스크 (pool->lock)
+    pfor_job *qnext;
+};
+
+struct parallel_task_group
+{
+    pfor_job job;
+    parallel_pool *pool;
+};
+
+/* pfor_body_fn → pfor_range_fn 어댑터 */
+typedef struct
+{
     pfor_body_fn body;
     void *userdata;
-    int thr_idx, nthreads, ncores, flags;
+} body_adapter;
+
+/* 잠들기/깨우기: seq 가 바뀌면 깨어난다. 기다리는 쪽은 spin_ns 동안 pause 로 돌며 seq 를
+ * 보다가 futex 로 잠들고, 깨우는 쪽은 잠든 스레드가 있을 때만 futex_wake 를 부른다 */
+typedef struct
+{
+    unsigned seq;
+    int parked;         // futex 에서 자는 스레드 수
+} pool_event;
+
+/* sched_setattr(2) 의 인자 (glibc 가 감싸지 않는다). 크기는 SCHED_ATTR_SIZE_VER0 */
+typedef struct
+{
+    uint32_t size, policy;
+    uint64_t flags;
+    int32_t  nice;
+    uint32_t priority;
+    uint64_t runtime, deadline, period;
+} sched_attr_t;
+
+typedef struct
+{
+    parallel_pool *pool;
+    pthread_t th;
+    int thr_idx;
     int assigned_core;
+    int depth;          // 지금 실행 중인 job 의 깊이
+    pfor_job *job;      // 지금 실행 중인 job (parallel_cancel 대상)
+    void *local;        // hooks.init 반환값
+    sched_attr_t base;  // pool 기본 스케줄링을 적용한 뒤의 실제 값 (되돌릴 곳)
+    int base_ok;        // base 를 읽었다
+    int overridden;     // 호출별 sched 로 바꿔 둔 상태, cur 가 그 값
+    parallel_sched cur;
 } worker_ctx;
 
+struct parallel_pool
+{
+    pthread_mutex_t lock;
+    pool_event wake;            // 워커: 새 job 또는 종료
+    pool_event idle;            // 제출자: job 완료
+    long spin_ns;               // 잠들기 전에 도는 시간, < 0 이면 잠들지 않는다
+    pfor_job  *head, *tail;     // 청크가 남은 job 큐
+    int shutdown;
+    int nthreads, ncores, flags;
+    parallel_sched sched;       // 워커 기본 스케줄링 (attr.sched)
+    pworker_init_fn init;
+    pworker_fini_fn fini;
+    void *hook_arg;
+    worker_ctx *workers;
+    int *core_ids;
+    worker_ctx ext;             // 밖에서 wait 하며 돕는 스레드가 빌려 쓰는 슬롯 (번호 nthreads)
+    int ext_busy;               // ext 를 쓰는 스레드가 있다 (pool->lock)
+    int ext_ready;              // ext.local 을 init 으로 만들었다
+};
+
+/* 비동기 루프 하나. 일회성 pool 이면 owned 에 들고 있다 */
+struct parallel_future
+{
+    pfor_job job;
+    parallel_pool *pool;
+    body_adapter adapter;
+    int owns_pool;
+    parallel_pool owned;
+};
+
+static __thread worker_ctx *tls_worker;
+
 
 /* 코어 핀닝 */
 static void pin_to_core(int core)
@@ -82,6 +211,118 @@ static void try_enable_realtime(void)
 #endif
 }
 
+#ifndef SCHED_DEADLINE
+#  define SCHED_DEADLINE 6
+#endif
+
+static int sched_valid(const parallel_sched *sp)
+{
+    switch (sp->policy)
+    {
+        case PARALLEL_SCHED_INHERIT:
+        case PARALLEL_SCHED_IDLE:
+            return 1;
+        case PARALLEL_SCHED_NORMAL:
+        case PARALLEL_SCHED_BATCH:
+            return sp->nice >= -20 && sp->nice <= 19;
+        case PARALLEL_SCHED_FIFO:
+        case PARALLEL_SCHED_RR:
+            return sp->priority >= 1 && sp->priority <= 99;
+        case PARALLEL_SCHED_DEADLINE:
+        {
+            unsigned long d = sp->deadline_ns ? sp->deadline_ns : sp->period_ns;
+            unsigned long p = sp->period_ns ? sp->period_ns : d;
+            return sp->runtime_ns > 0 && sp->runtime_ns <= d && d <= p;
+        }
+        default:
+            return 0;
+    }
+}
+
+static int sched_equal(const parallel_sched *a, const parallel_sched *b)
+{
+    return a->policy == b->policy && a->priority == b->priority && a->nice == b->nice
+        && a->runtime_ns == b->runtime_ns && a->deadline_ns == b->deadline_ns
+        && a->period_ns == b->period_ns;
+}
+
+static int sched_set_raw(const sched_attr_t *a)
+{
+#ifdef SYS_sched_setattr
+    return syscall(SYS_sched_setattr, 0, a, 0) == 0 ? 0 : -1;
+#else
+    (void)a;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static int sched_get_raw(sched_attr_t *a)
+{
+#ifdef SYS_sched_getattr
+    memset(a, 0, sizeof(*a));
+    return syscall(SYS_sched_getattr, 0, a, (unsigned)sizeof(*a), 0) == 0 ? 0 : -1;
+#else
+    (void)a;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+/* 호출 스레드에 적용. INHERIT 는 아무것도 안 한다. 실패하면 경고 한 번, -1 */
+static int sched_apply(const parallel_sched *sp)
+{
+    sched_attr_t a = { .size = sizeof(a) };
+    switch (sp->policy)
+    {
+        case PARALLEL_SCHED_INHERIT:  return 0;
+        case PARALLEL_SCHED_NORMAL:   a.policy = SCHED_OTHER; a.nice = sp->nice; break;
+        case PARALLEL_SCHED_BATCH:    a.policy = SCHED_BATCH; a.nice = sp->nice; break;
+        case PARALLEL_SCHED_IDLE:     a.policy = SCHED_IDLE; break;
+        case PARALLEL_SCHED_FIFO:     a.policy = SCHED_FIFO; a.priority = (uint32_t)sp->priority; break;
+        case PARALLEL_SCHED_RR:       a.policy = SCHED_RR;   a.priority = (uint32_t)sp->priority; break;
+        case PARALLEL_SCHED_DEADLINE:
+            a.policy   = SCHED_DEADLINE;
+            a.runtime  = sp->runtime_ns;
+            a.deadline = sp->deadline_ns ? sp->deadline_ns : sp->period_ns;
+            a.period   = sp->period_ns   ? sp->period_ns   : a.deadline;
+            break;
+        default: return -1;
+    }
+    if (sched_set_raw(&a) == 0) return 0;
+    if (sp->policy == PARALLEL_SCHED_DEADLINE && (errno == EBUSY || errno == EPERM))
+        warn_realtime_failure("sched_setattr(SCHED_DEADLINE) (admission refused or CPU affinity restricted)");
+    else
+        warn_realtime_failure("sched_setattr");
+    return -1;
+}
+
+/* 워커 시작 시: pool 기본을 적용하고 그 결과를 되돌릴 곳으로 기억한다 */
+static void worker_sched_init(worker_ctx *ctx)
+{
+    parallel_pool *pool = ctx->pool;
+    if (pool->sched.policy != PARALLEL_SCHED_INHERIT) sched_apply(&pool->sched);
+    else if (pool->flags & PARALLEL_OPT_REALTIME) try_enable_realtime();
+    ctx->base_ok = sched_get_raw(&ctx->base) == 0;
+}
+
+/* job 을 잡을 때 (want = 그 job 의 sched) 와 일이 없을 때 (want = NULL, 기본으로) */
+static void worker_sched_switch(worker_ctx *ctx, const parallel_sched *want)
+{
+    if (want)
+    {
+        if (ctx->overridden && sched_equal(&ctx->cur, want)) return;
+        if (!ctx->base_ok) return;      // 되돌릴 수 없으면 바꾸지 않는다
+        sched_apply(want);
+        ctx->cur = *want;
+        ctx->overridden = 1;
+        return;
+    }
+    if (!ctx->overridden) return;
+    if (sched_set_raw(&ctx->base) != 0) warn_realtime_failure("sched_setattr (restore)");
+    ctx->overridden = 0;
+}
+
 static inline __attribute__((always_inline))
 long atomic_fetch_add_long(volatile long *ptr, long inc)
 {
@@ -145,158 +386,1726 @@ long branchless_min_long(long a, long b)
 }
 
 static inline __attribute__((always_inline))
-void execute_chunk(long start, long stop, pfor_body_fn body, void *userdata)
+void cpu_relax(void)
 {
-    if (UNLIKELY(start >= stop)) return;
-    for (long i = start; i < stop; ++i) body(i, userdata);
+    #if defined(__x86_64__)
+        asm volatile("pause" ::: "memory");
+    #elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+    #else
+        asm volatile("" ::: "memory");
+    #endif
 }
 
-static void *
-#if __has_attribute(hot)
-__attribute__((hot))
-#endif
-worker_main(void *arg)
+static inline long now_ns(void)
 {
-    worker_ctx *ctx = (worker_ctx *)arg;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static long futex(unsigned *addr, int op, unsigned val)
+{
+    return syscall(SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+/* pool->lock 보유 상태에서 호출, 돌아올 때도 보유. 깨어난 뒤 조건은 호출자가 다시 본다 */
+static void event_wait(parallel_pool *pool, pool_event *ev)
+{
+    unsigned seq = ev->seq;
+    long spin = pool->spin_ns;
+    pthread_mutex_unlock(&pool->lock);
 
-    if ((ctx->flags & PARALLEL_OPT_PIN_CORE) && ctx->assigned_core >= 0)
+    if (spin != 0)
     {
-        pin_to_core(ctx->assigned_core);
+        long deadline = spin > 0 ? now_ns() + spin : 0;
+        for (unsigned k = 1; ; ++k)
+        {
+            if (__atomic_load_n(&ev->seq, __ATOMIC_ACQUIRE) != seq) goto woken;
+            cpu_relax();
+            if ((k & 63) != 0) continue;
+            // 코어를 나눠 쓰면 깨울 스레드에게 양보 (전용 코어면 곧바로 돌아온다)
+            sched_yield();
+            if (spin > 0 && now_ns() >= deadline) break;
+        }
     }
 
-    if (ctx->flags & PARALLEL_OPT_REALTIME)
+    // parked 증가와 seq 재확인 / seq 증가와 parked 확인이 seq_cst 라 wake 를 놓치지 않는다
+    __atomic_fetch_add(&ev->parked, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&ev->seq, __ATOMIC_SEQ_CST) == seq)
+        futex(&ev->seq, FUTEX_WAIT_PRIVATE, seq);
+    __atomic_fetch_sub(&ev->parked, 1, __ATOMIC_RELAXED);
+woken:
+    pthread_mutex_lock(&pool->lock);
+}
+
+/* pool->lock 보유 상태에서 호출. 도는 스레드는 모두, 잠든 스레드는 n 개 깨운다 */
+static void event_kick(pool_event *ev, int n)
+{
+    __atomic_fetch_add(&ev->seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ev->parked, __ATOMIC_SEQ_CST) > 0)
+        futex(&ev->seq, FUTEX_WAKE_PRIVATE, (unsigned)n);
+}
+
+static inline void range_lock(steal_range *r)
+{
+    while (__sync_lock_test_and_set(&r->lock, 1))
     {
-        try_enable_realtime();
+        while (__atomic_load_n(&r->lock, __ATOMIC_RELAXED)) cpu_relax();
     }
+}
+
+static inline void range_unlock(steal_range *r)
+{
+    __sync_lock_release(&r->lock);
+}
 
-    pfor_body_fn      body      = ctx->body;
-    void             *userdata  = ctx->userdata;
-    volatile long    *nextptr   = ctx->next;
-    const long        end       = ctx->end;
-    const long        chunk     = ctx->chunk;
+static inline int range_empty(const steal_range *r)
+{
+    return __atomic_load_n(&r->lo, __ATOMIC_RELAXED) >= __atomic_load_n(&r->hi, __ATOMIC_RELAXED);
+}
+
+static __attribute__((noinline))
+void execute_chunk_stats(long start, long stop, pfor_range_fn fn, void *userdata,
+                         parallel_worker_stats *st)
+{
+    long t0 = now_ns();
+    fn(start, stop, userdata);
+    long t1 = now_ns();
+    int cpu = sched_getcpu();
+    if (st->first_start_ns < 0) st->first_start_ns = t0;
+    else if (cpu != st->cpu)    st->migrations++;
+    st->last_finish_ns = t1;
+    st->busy_ns += t1 - t0;
+    st->chunks++;
+    st->iterations += stop - start;
+    st->cpu = cpu;
+}
+
+static inline __attribute__((always_inline))
+void execute_chunk(long start, long stop, pfor_range_fn fn, void *userdata,
+                   parallel_worker_stats *st)
+{
+    if (UNLIKELY(start >= stop)) return;
+    if (UNLIKELY(st)) { execute_chunk_stats(start, stop, fn, userdata, st); return; }
+    fn(start, stop, userdata);
+}
+
+static void body_range(long start, long stop, void *arg)
+{
+    const body_adapter *a = (const body_adapter *)arg;
+    pfor_body_fn body = a->body;
+    void *userdata = a->userdata;
+    for (long i = start; i < stop; ++i) body(i, userdata);
+}
+
+static void
+#if __has_attribute(hot)
+__attribute__((hot))
+#endif
+run_shared(pfor_job *job, parallel_worker_stats *st)
+{
+    pfor_range_fn     fn        = job->fn;
+    void             *userdata  = job->userdata;
+    volatile long    *nextptr   = &job->next;
+    const long        end       = job->end;
+    const long        chunk     = job->chunk;
 
     for(;;)
     {
+        if (UNLIKELY(__atomic_load_n(&job->cancelled, __ATOMIC_RELAXED))) break;
         long start = atomic_fetch_add_long(nextptr, chunk);
         if (start >= end) break;
         long stop  = branchless_min_long(start + chunk, end);
-        execute_chunk(start, stop, body, userdata);
+        execute_chunk(start, stop, fn, userdata, st);
     }
-    return NULL;
 }
 
-int parallel_for
-(
-    long begin, long end, long chunk,
-    int nthreads, int options,
-    pfor_body_fn body,
-    void *userdata
-)
+/* guided/adaptive: CAS로 남은 양에 비례한 크기를 떼어 간다 */
+static void
+#if __has_attribute(hot)
+__attribute__((hot))
+#endif
+run_guided(pfor_job *job, int adaptive, parallel_worker_stats *st)
 {
-    if (UNLIKELY(!body || end <= begin)) return -1;
-    if (chunk <= 0) chunk = 1;
+    pfor_range_fn     fn        = job->fn;
+    void             *userdata  = job->userdata;
+    volatile long    *nextptr   = &job->next;
+    const long        end       = job->end;
+    const long        min_chunk = job->chunk;
+    const long        split     = 2L * job->nthreads;
+    long              ns_iter   = 0;    // adaptive: 워커별 반복당 ns 추정치 (EWMA)
 
-    volatile long __attribute__((aligned(64))) next = begin;
-    volatile long *shared_next = &next;
+    for(;;)
+    {
+        if (UNLIKELY(__atomic_load_n(&job->cancelled, __ATOMIC_RELAXED))) break;
+        long start  = __atomic_load_n(nextptr, __ATOMIC_RELAXED);
+        long remain = end - start;
+        if (remain <= 0) break;
 
-    long sys_ncores = sysconf(_SC_NPROCESSORS_ONLN);
-    if (sys_ncores < 1) sys_ncores = 1;
+        long sz = remain / split;
+        if (adaptive)
+        {
+            // 첫 청크는 1회 반복으로 측정, 이후 목표 시간에 맞춘다 (guided 상한 유지)
+            long want = ns_iter > 0 ? PARALLEL_ADAPTIVE_TARGET_NS / ns_iter : 1;
+            sz = branchless_min_long(sz, want);
+            if (sz < 1) sz = 1;
+        }
+        else if (sz < min_chunk)
+        {
+            sz = min_chunk;
+        }
+        long stop = start + branchless_min_long(sz, remain);
+        if (!__sync_bool_compare_and_swap(nextptr, start, stop)) continue;
 
-    cpu_set_t affinity_mask;
-    int *core_ids = NULL;
-    int core_count = 0;
-    if (options & PARALLEL_OPT_PIN_CORE)
-    {
-        CPU_ZERO(&affinity_mask);
-        if (sched_getaffinity(0, sizeof(affinity_mask), &affinity_mask) == 0)
+        if (!adaptive)
         {
-            // Limit pinning choices to the CPUs currently available to this process.
-            int available = CPU_COUNT(&affinity_mask);
-            if (available > 0)
-            {
-                core_ids = (int *)malloc((size_t)available * sizeof(*core_ids));
-                if (core_ids)
-                {
-                    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
-                    {
-                        if (!CPU_ISSET(cpu, &affinity_mask)) continue;
-                        core_ids[core_count++] = cpu;
-                        if (core_count == available) break;
-                    }
-                }
-                else
-                {
-                    core_count = 0;
-                }
-            }
+            execute_chunk(start, stop, fn, userdata, st);
+            continue;
         }
-    }
 
-    int active_cores = core_count > 0 ? core_count : (int)sys_ncores;
-    if (active_cores < 1) active_cores = 1;
-    if (nthreads <= 0) nthreads = active_cores;
-    if ((options & PARALLEL_OPT_PIN_CORE) && nthreads > active_cores)
-    {
-        nthreads = active_cores;
+        long t0 = now_ns();
+        execute_chunk(start, stop, fn, userdata, st);
+        long sample = (now_ns() - t0) / (stop - start);
+        if (sample < 1) sample = 1;
+        ns_iter = ns_iter > 0 ? (3 * ns_iter + sample) / 4 : sample;
     }
+}
 
-    pthread_t  *ths  = (pthread_t *)calloc(nthreads, sizeof(*ths));
-    worker_ctx *ctxs = (worker_ctx *)calloc(nthreads, sizeof(*ctxs));
-    if (UNLIKELY(!ths || !ctxs)) { free(ths); free(ctxs); free(core_ids); return -2; }
+/* victim의 남은 range 뒤쪽 절반을 떼어 온다. chunk 이하면 전부 */
+static int steal_half(steal_range *victim, long *lo, long *hi)
+{
+    // lock 없이 먼저 훑기 (lo/hi 쓰기는 lock 안에서 relaxed store)
+    if (range_empty(victim)) return 0;
+    range_lock(victim);
+    long n = victim->hi - victim->lo;
+    if (n <= 0) { range_unlock(victim); return 0; }
+    long mid = victim->lo + n / 2;
+    *lo = mid;
+    *hi = victim->hi;
+    __atomic_store_n(&victim->hi, mid, __ATOMIC_RELAXED);
+    range_unlock(victim);
+    return 1;
+}
 
-    for (int t = 0; t < nthreads; ++t)
+static void
+#if __has_attribute(hot)
+__attribute__((hot))
+#endif
+run_steal(pfor_job *job, int slot, int steal, parallel_worker_stats *st)
+{
+    pfor_range_fn     fn        = job->fn;
+    void             *userdata  = job->userdata;
+    const long        chunk     = job->chunk;
+    const int         nranges   = job->nranges;
+    steal_range      *mine      = &job->ranges[slot];
+    unsigned int      seed      = (unsigned int)slot * 2654435761u + 1u;
+
+    for(;;)
     {
-        int chosen_core = -1;
-        if (options & PARALLEL_OPT_PIN_CORE)
+        if (UNLIKELY(__atomic_load_n(&job->cancelled, __ATOMIC_RELAXED))) break;
+        range_lock(mine);
+        long start = mine->lo;
+        long stop  = branchless_min_long(start + chunk, mine->hi);
+        if (start < stop) __atomic_store_n(&mine->lo, stop, __ATOMIC_RELAXED);
+        range_unlock(mine);
+
+        if (LIKELY(start < stop))
         {
-            if (core_count > 0)
-                chosen_core = core_ids[t % core_count];
-            else if (active_cores > 0)
-                chosen_core = t % active_cores;
+            execute_chunk(start, stop, fn, userdata, st);
+            continue;
         }
 
-        ctxs[t] = (worker_ctx)
+        if (!steal) break;      // static: 내 구간만
+
+        // 내 deque가 비었으면 임의의 victim부터 한 바퀴 돌며 훔친다
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        int first = (int)(seed % (unsigned int)nranges);
+        long lo = 0, hi = 0;
+        int got = 0;
+        for (int k = 0; k < nranges && !got; ++k)
         {
-            .begin=begin, .end=end, .chunk=chunk, .next=shared_next,
-            .body=body, .userdata=userdata,
-            .thr_idx=t, .nthreads=nthreads, .ncores=active_cores,
-            .flags=options, .assigned_core=chosen_core
-        };
+            int v = first + k;
+            if (v >= nranges) v -= nranges;
+            if (v == slot) continue;
+            got = steal_half(&job->ranges[v], &lo, &hi);
+        }
+        // 모두 비었음: 이동 중인 range는 그걸 든 thief가 끝까지 처리한다
+        if (!got) break;
 
-        pthread_attr_t attr;
-        pthread_attr_t *attr_ptr = NULL;
-        if (chosen_core >= 0)
+        range_lock(mine);
+        __atomic_store_n(&mine->lo, lo, __ATOMIC_RELAXED);
+        __atomic_store_n(&mine->hi, hi, __ATOMIC_RELAXED);
+        range_unlock(mine);
+    }
+}
+
+/* 태스크를 하나씩 꺼내 실행. 꺼내는 동안만 pool->lock */
+static void run_tasks(parallel_pool *pool, pfor_job *job)
+{
+    for(;;)
+    {
+        pthread_mutex_lock(&pool->lock);
+        ptask *t = job->tasks;
+        if (t)
         {
-            if (pthread_attr_init(&attr) == 0)
-            {
-                cpu_set_t set;
-                CPU_ZERO(&set);
-                CPU_SET(chosen_core, &set);
-                if (pthread_attr_setaffinity_np(&attr, sizeof(set), &set) == 0)
-                {
-                    attr_ptr = &attr;
-                }
-                else
-                {
-                    pthread_attr_destroy(&attr);
-                }
-            }
+            job->tasks = t->next;
+            if (!job->tasks) job->tasks_tail = NULL;
         }
+        pthread_mutex_unlock(&pool->lock);
+        if (!t) break;
+        t->fn(t->arg);
+        free(t);
+    }
+}
 
-        int create_rc = pthread_create(&ths[t], attr_ptr, worker_main, &ctxs[t]);
-        if (attr_ptr)
+/* PARALLEL_OPT_PERF: 스레드마다 처음 쓸 때 한 번 여는 카운터. 하드웨어 넷은 한 그룹으로 같이
+ * 돌고 (read 한 번), context switch 는 소프트웨어 카운터. 스레드가 끝나면 닫는다 */
+enum { PERF_CYCLES, PERF_INSTRUCTIONS, PERF_LLC_MISSES, PERF_BRANCH_MISSES, PERF_CSW, PERF_N };
+
+static const size_t perf_field[PERF_N] =
+{
+    offsetof(parallel_perf_counts, cycles),
+    offsetof(parallel_perf_counts, instructions),
+    offsetof(parallel_perf_counts, llc_misses),
+    offsetof(parallel_perf_counts, branch_misses),
+    offsetof(parallel_perf_counts, context_switches),
+};
+
+static const unsigned long perf_hw_config[PERF_CSW] =
+{
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+static const parallel_perf_counts perf_none = { -1, -1, -1, -1, -1 };
+
+typedef struct
+{
+    int opened;
+    int group;              // 하드웨어 그룹 리더 (처음 열린 것), 없으면 -1
+    int nhw;
+    int hw[PERF_CSW];       // 그룹 read 순서
+    int hw_kind[PERF_CSW];  // → PERF_*
+    int csw;
+} perf_thread;
+
+typedef struct
+{
+    long v[PERF_N];         // 못 읽었으면 -1
+    unsigned long enabled, running;     // 하드웨어 그룹이 켜져 있던 / 실제로 돈 시간
+} perf_sample;
+
+static __thread perf_thread tls_perf;
+static pthread_key_t perf_key;
+static pthread_once_t perf_once = PTHREAD_ONCE_INIT;
+
+static void perf_thread_close(void *p)
+{
+    perf_thread *pt = (perf_thread *)p;
+    for (int i = 0; i < pt->nhw; ++i) close(pt->hw[i]);
+    if (pt->csw >= 0) close(pt->csw);
+    pt->nhw = 0;
+    pt->group = pt->csw = -1;
+}
+
+static void perf_key_init(void)
+{
+    pthread_key_create(&perf_key, perf_thread_close);
+}
+
+/* 이 스레드용. 커널까지 세지 못하면 (perf_event_paranoid) 사용자 공간만. 실패 시 -1 */
+static int perf_open(unsigned type, unsigned long config, int group)
+{
+    struct perf_event_attr a;
+    memset(&a, 0, sizeof(a));
+    a.size        = sizeof(a);
+    a.type        = type;
+    a.config      = config;
+    a.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    a.exclude_hv  = 1;
+    if (type == PERF_TYPE_SOFTWARE) a.read_format = 0;
+    int fd = (int)syscall(SYS_perf_event_open, &a, 0, -1, group, PERF_FLAG_FD_CLOEXEC);
+    if (fd < 0 && (errno == EACCES || errno == EPERM))
+    {
+        a.exclude_kernel = 1;
+        fd = (int)syscall(SYS_perf_event_open, &a, 0, -1, group, PERF_FLAG_FD_CLOEXEC);
+    }
+    return fd;
+}
+
+static perf_thread *perf_thread_get(void)
+{
+    perf_thread *pt = &tls_perf;
+    if (LIKELY(pt->opened)) return pt;
+    pt->opened = 1;
+    pt->group = -1;
+    for (int k = 0; k < PERF_CSW; ++k)
+    {
+        int fd = perf_open(PERF_TYPE_HARDWARE, perf_hw_config[k], pt->group);
+        if (fd < 0) continue;
+        if (pt->group < 0) pt->group = fd;
+        pt->hw_kind[pt->nhw] = k;
+        pt->hw[pt->nhw++] = fd;
+    }
+    pt->csw = perf_open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, -1);
+    pthread_once(&perf_once, perf_key_init);
+    pthread_setspecific(perf_key, pt);
+    return pt;
+}
+
+static void perf_read(const perf_thread *pt, perf_sample *s)
+{
+    for (int k = 0; k < PERF_N; ++k) s->v[k] = -1;
+    s->enabled = s->running = 0;
+    if (pt->group >= 0)
+    {
+        // { nr, time_enabled, time_running, value[nr] }
+        uint64_t buf[3 + PERF_CSW];
+        ssize_t want = (ssize_t)((size_t)(3 + pt->nhw) * sizeof(uint64_t));
+        if (read(pt->group, buf, sizeof(buf)) == want && buf[0] == (uint64_t)pt->nhw)
         {
-            pthread_attr_destroy(&attr);
+            s->enabled = buf[1];
+            s->running = buf[2];
+            for (int i = 0; i < pt->nhw; ++i) s->v[pt->hw_kind[i]] = (long)buf[3 + i];
         }
-        if (UNLIKELY(create_rc != 0))
+    }
+    uint64_t csw;
+    if (pt->csw >= 0 && read(pt->csw, &csw, sizeof(csw)) == (ssize_t)sizeof(csw)) s->v[PERF_CSW] = (long)csw;
+}
+
+static inline void perf_add(parallel_perf_counts *c, int k, long d)
+{
+    long *f = (long *)((char *)c + perf_field[k]);
+    *f = (*f < 0 ? 0 : *f) + d;
+}
+
+/* a → b 증분을 c 에 더한다. 그룹이 다중화로 일부만 돌았으면 비율로 늘린다 */
+static void perf_accumulate(const perf_sample *a, const perf_sample *b, parallel_perf_counts *c)
+{
+    unsigned long en = b->enabled - a->enabled, run = b->running - a->running;
+    for (int k = 0; k < PERF_N; ++k)
+    {
+        if (a->v[k] < 0 || b->v[k] < 0) continue;
+        long d = b->v[k] - a->v[k];
+        if (k != PERF_CSW)
         {
-            perror("pthread_create");
-            for (int j = 0; j < t; ++j) pthread_join(ths[j], NULL);
-            free(ths); free(ctxs); free(core_ids);
-            return -3;
+            if (!run) continue;
+            if (run < en) d = (long)((double)d * (double)en / (double)run);
         }
+        perf_add(c, k, d);
     }
-    for (int t = 0; t < nthreads; ++t) pthread_join(ths[t], NULL);
-    free(ths); free(ctxs); free(core_ids);
-    return 0;
+}
+
+static void run_job(parallel_pool *pool, pfor_job *job, int slot)
+{
+    if (job->kind == JOB_TASKS)
+    {
+        run_tasks(pool, job);
+        return;
+    }
+    parallel_worker_stats *st = job->stats ? &job->stats[slot].s : NULL;
+    perf_thread *pt = NULL;
+    perf_sample p0;
+    if (UNLIKELY(st && (job->flags & PARALLEL_OPT_PERF)))
+    {
+        pt = perf_thread_get();
+        perf_read(pt, &p0);
+    }
+    switch (job->flags & PARALLEL_OPT_SCHED_MASK)
+    {
+        case PARALLEL_OPT_SCHED_STEAL:
+            run_steal(job, slot, 1, st);
+            break;
+        case PARALLEL_OPT_SCHED_STATIC:
+            run_steal(job, slot, 0, st);
+            break;
+        case PARALLEL_OPT_SCHED_GUIDED:
+            run_guided(job, 0, st);
+            break;
+        case PARALLEL_OPT_SCHED_ADAPTIVE:
+            run_guided(job, 1, st);
+            break;
+        default:
+            run_shared(job, st);
+            break;
+    }
+    if (UNLIKELY(pt))
+    {
+        perf_sample p1;
+        perf_read(pt, &p1);
+        perf_accumulate(&p0, &p1, &st->perf);
+    }
+}
+
+/* pool->lock 보유 상태에서 호출 */
+static void job_unlink(parallel_pool *pool, pfor_job *job)
+{
+    pfor_job **pp = &pool->head, *prev = NULL;
+    while (*pp && *pp != job) { prev = *pp; pp = &(*pp)->qnext; }
+    if (!*pp) return;
+    *pp = job->qnext;
+    if (pool->tail == job) pool->tail = prev;
+    job->qnext = NULL;
+}
+
+/* 더 나눠줄 청크가 없는가 */
+static int job_drained(const pfor_job *job)
+{
+    if (job->kind == JOB_TASKS) return job->tasks == NULL;
+    if (!job->ranges) return __atomic_load_n(&job->next, __ATOMIC_RELAXED) >= job->end;
+    for (int t = 0; t < job->nranges; ++t)
+    {
+        if (!range_empty(&job->ranges[t])) return 0;
+    }
+    return 1;
+}
+
+/* static 은 자기 구간이 남은 워커만 참여한다 */
+static int job_has_work_for(const pfor_job *job, int slot)
+{
+    if (job->kind == JOB_TASKS) return job->tasks != NULL;
+    if ((job->flags & PARALLEL_OPT_SCHED_MASK) == PARALLEL_OPT_SCHED_STATIC)
+        return slot < job->nranges && !range_empty(&job->ranges[slot]);
+    return 1;
+}
+
+/* pool->lock 보유 상태에서 호출 */
+static pfor_job *pick_job(parallel_pool *pool, int slot)
+{
+    for (pfor_job *job = pool->head; job; job = job->qnext)
+    {
+        if (job_has_work_for(job, slot)) return job;
+    }
+    return NULL;
+}
+
+/* 기다리는 워커가 도울 수 있는 job: 기다리는 job 자신과 그보다 깊은 (중첩된) job 만.
+ * 바깥 job 의 긴 청크를 집어 들어 기다림이 늘어지지 않게 한다. pool->lock 보유 상태에서 호출 */
+static pfor_job *pick_nested_job(parallel_pool *pool, int slot, const pfor_job *waited)
+{
+    for (pfor_job *job = pool->head; job; job = job->qnext)
+    {
+        if ((job == waited || job->depth > waited->depth) && job_has_work_for(job, slot)) return job;
+    }
+    return NULL;
+}
+
+/* pool->lock 보유 상태에서 호출 */
+static void job_enqueue(parallel_pool *pool, pfor_job *job)
+{
+    job->qnext = NULL;
+    if (pool->tail) pool->tail->qnext = job;
+    else            pool->head = job;
+    pool->tail = job;
+    event_kick(&pool->wake, INT_MAX);
+    // 중첩 job 을 기다리며 잠든 워커도 도울 수 있게
+    event_kick(&pool->idle, INT_MAX);
+}
+
+/* pool->lock 보유 상태에서 호출 */
+static void job_finish(parallel_pool *pool, pfor_job *job)
+{
+    if (job->stats) job->t_done = now_ns();
+    job->done = 1;
+    event_kick(&pool->idle, INT_MAX);
+}
+
+/* pool->lock 보유 상태에서 호출 */
+static void job_leave(parallel_pool *pool, pfor_job *job)
+{
+    if (!job->exhausted && job_drained(job))
+    {
+        job->exhausted = 1;
+        job_unlink(pool, job);
+    }
+    if (--job->refs == 0 && job->exhausted) job_finish(pool, job);
+}
+
+static void *worker_main(void *arg)
+{
+    worker_ctx *ctx = (worker_ctx *)arg;
+    parallel_pool *pool = ctx->pool;
+
+    // 핀닝/RT 설정은 워커 시작 시 한 번만
+    if ((pool->flags & PARALLEL_OPT_PIN_CORE) && ctx->assigned_core >= 0)
+    {
+        pin_to_core(ctx->assigned_core);
+    }
+
+    worker_sched_init(ctx);
+
+    if (pool->init) ctx->local = pool->init(ctx->thr_idx, pool->hook_arg);
+    tls_worker = ctx;
+
+    pthread_mutex_lock(&pool->lock);
+    for(;;)
+    {
+        pfor_job *job;
+        while (!(job = pick_job(pool, ctx->thr_idx)) && !pool->shutdown)
+        {
+            if (ctx->overridden)
+            {
+                // 호출별 우선순위로 잠들거나 돌지 않게
+                pthread_mutex_unlock(&pool->lock);
+                worker_sched_switch(ctx, NULL);
+                pthread_mutex_lock(&pool->lock);
+                continue;
+            }
+            event_wait(pool, &pool->wake);
+        }
+        if (!job) break;    // shutdown, 남은 job 없음
+
+        job->refs++;
+        ctx->depth = job->depth;
+        ctx->job   = job;
+        const parallel_sched *want = job->has_sched ? &job->sched : NULL;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (want || ctx->overridden) worker_sched_switch(ctx, want);
+
+        run_job(pool, job, ctx->thr_idx);
+
+        pthread_mutex_lock(&pool->lock);
+        ctx->depth = 0;
+        ctx->job   = NULL;
+        job_leave(pool, job);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    tls_worker = NULL;
+    if (pool->fini) pool->fini(ctx->thr_idx, ctx->local, pool->hook_arg);
+    return NULL;
+}
+
+static void pool_stop(parallel_pool *pool, int started)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    event_kick(&pool->wake, INT_MAX);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int t = 0; t < started; ++t) pthread_join(pool->workers[t].th, NULL);
+    if (pool->ext_ready && pool->fini) pool->fini(pool->ext.thr_idx, pool->ext.local, pool->hook_arg);
+
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers); free(pool->core_ids);
+    pool->workers = NULL; pool->core_ids = NULL;
+}
+
+/* cgroup CPU 할당량보다 많은 스레드는 스로틀링만 당한다 */
+static int cap_quota(int n)
+{
+    int quota = topo_cpu_quota();
+    return quota > 0 && quota < n ? quota : n;
+}
+
+int parallel_default_threads(void)
+{
+    return cap_quota(topo_cpu_count());
+}
+
+static int pool_start(parallel_pool *pool, const parallel_pool_attr *pattr)
+{
+    int nthreads = pattr->nthreads;
+    int options  = pattr->options;
+    memset(pool, 0, sizeof(*pool));
+    if (UNLIKELY(!sched_valid(&pattr->sched))) return -1;
+
+    int *core_ids = NULL;
+    int core_count = 0;
+    if (options & PARALLEL_OPT_PIN_CORE)
+    {
+        // Limit pinning choices to the CPUs currently available to this process,
+        // ordered by the requested placement policy.
+        core_count = topo_cpu_order(options, &core_ids);
+    }
+
+    int active_cores = core_count > 0 ? core_count : topo_cpu_count();
+    if (nthreads <= 0) nthreads = cap_quota(active_cores);
+    if ((options & PARALLEL_OPT_PIN_CORE) && nthreads > active_cores)
+    {
+        nthreads = active_cores;
+    }
+
+    worker_ctx *workers = (worker_ctx *)calloc(nthreads, sizeof(*workers));
+    if (UNLIKELY(!workers)) { free(core_ids); return -2; }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pool->nthreads = nthreads;
+    pool->ncores   = active_cores;
+    pool->flags    = options;
+    pool->init     = pattr->init;
+    pool->fini     = pattr->fini;
+    pool->hook_arg = pattr->hook_arg;
+    pool->spin_ns  = pattr->spin_ns;
+    pool->sched    = pattr->sched;
+    pool->workers  = workers;
+    pool->core_ids = core_ids;
+    pool->ext      = (worker_ctx){ .pool=pool, .thr_idx=nthreads, .assigned_core=-1 };
+
+    for (int t = 0; t < nthreads; ++t)
+    {
+        int chosen_core = -1;
+        if (options & PARALLEL_OPT_PIN_CORE)
+        {
+            if (core_count > 0)
+                chosen_core = core_ids[t % core_count];
+            else if (active_cores > 0)
+                chosen_core = t % active_cores;
+        }
+
+        workers[t] = (worker_ctx)
+        {
+            .pool=pool, .thr_idx=t, .assigned_core=chosen_core
+        };
+
+        pthread_attr_t attr;
+        pthread_attr_t *attr_ptr = NULL;
+        if (chosen_core >= 0)
+        {
+            if (pthread_attr_init(&attr) == 0)
+            {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(chosen_core, &set);
+                if (pthread_attr_setaffinity_np(&attr, sizeof(set), &set) == 0)
+                {
+                    attr_ptr = &attr;
+                }
+                else
+                {
+                    pthread_attr_destroy(&attr);
+                }
+            }
+        }
+
+        int create_rc = pthread_create(&workers[t].th, attr_ptr, worker_main, &workers[t]);
+        if (attr_ptr)
+        {
+            pthread_attr_destroy(&attr);
+        }
+        if (UNLIKELY(create_rc != 0))
+        {
+            perror("pthread_create");
+            pool_stop(pool, t);
+            return -3;
+        }
+    }
+    return 0;
+}
+
+/* 이 pool 의 워커 안이면 그 워커, 아니면 NULL */
+static worker_ctx *pool_self(const parallel_pool *pool)
+{
+    return tls_worker && tls_worker->pool == pool ? tls_worker : NULL;
+}
+
+/* job 이 끝날 때까지 기다린다. 워커라면 잠들기 전에 job 과 더 깊은 job 의 일을 돕는다
+ * (새 스레드 없이 중첩 가능). pool->lock 보유 상태에서 호출 */
+static void pool_wait(parallel_pool *pool, pfor_job *job)
+{
+    worker_ctx *self = pool_self(pool);
+    while (!job->done)
+    {
+        pfor_job *h = self ? pick_nested_job(pool, self->thr_idx, job) : NULL;
+        if (!h)
+        {
+            event_wait(pool, &pool->idle);
+            continue;
+        }
+        int depth = self->depth;
+        pfor_job *running = self->job;
+        h->refs++;
+        self->depth = h->depth;
+        self->job   = h;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_job(pool, h, self->thr_idx);
+
+        pthread_mutex_lock(&pool->lock);
+        self->depth = depth;
+        self->job   = running;
+        job_leave(pool, h);
+    }
+}
+
+/* 밖의 스레드가 기다리는 동안 ext 슬롯을 빌려 워커처럼 job 을 돕는다.
+ * ext 는 한 번에 한 스레드만: 이미 쓰는 중이면 그냥 잠든다. pool->lock 보유 상태에서 호출 */
+static void pool_help(parallel_pool *pool, pfor_job *job)
+{
+    worker_ctx *ext = &pool->ext;
+    if (pool->ext_busy) { pool_wait(pool, job); return; }
+    pool->ext_busy = 1;
+    if (!pool->ext_ready)
+    {
+        // 워커별 상태는 처음 도울 때 이 스레드에서 한 번 만든다 (fini 는 pool 종료 때)
+        pthread_mutex_unlock(&pool->lock);
+        if (pool->init) ext->local = pool->init(ext->thr_idx, pool->hook_arg);
+        pthread_mutex_lock(&pool->lock);
+        pool->ext_ready = 1;
+    }
+    worker_ctx *saved = tls_worker;     // 다른 pool 의 워커일 수도 있다
+    tls_worker = ext;
+    pool_wait(pool, job);
+    tls_worker = saved;
+    pool->ext_busy = 0;
+}
+
+/* pool->lock 보유 상태에서 호출 */
+static void pool_submit(parallel_pool *pool, pfor_job *job)
+{
+    worker_ctx *self = pool_self(pool);
+    job->depth = self ? self->depth + 1 : 0;
+    job_enqueue(pool, job);
+}
+
+/* job을 큐에 올리고 모든 워커가 빠져나갈 때까지 대기 */
+static void pool_run(parallel_pool *pool, pfor_job *job)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool_submit(pool, job);
+    pool_wait(pool, job);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/* 아직 나눠주지 않은 청크를 버린다. 실행 중인 청크는 끝까지 돌고, 워커는 다음 청크를
+ * 가져가기 전에 cancelled 를 보고 빠진다. pool->lock 보유 상태에서 호출 */
+static void job_cancel(parallel_pool *pool, pfor_job *job)
+{
+    if (job->exhausted) return;
+    if (!job_drained(job)) __atomic_store_n(&job->cancelled, 1, __ATOMIC_RELAXED);
+    job->exhausted = 1;
+    job_unlink(pool, job);
+    if (job->refs == 0) job_finish(pool, job);
+}
+
+/* PARALLEL_STATS 환경 변수: 비어 있지 않고 "0" 이 아니면 모든 루프에서 통계를 켠다.
+ * "perf" 면 카운터까지. 반환값은 켤 옵션 비트 */
+static int stats_env(void)
+{
+    static int cached = -1;
+    int v = __atomic_load_n(&cached, __ATOMIC_RELAXED);
+    if (v < 0)
+    {
+        const char *e = getenv("PARALLEL_STATS");
+        v = !e || !*e || strcmp(e, "0") == 0 ? 0
+          : PARALLEL_OPT_STATS | (strcmp(e, "perf") == 0 ? PARALLEL_OPT_PERF : 0);
+        __atomic_store_n(&cached, v, __ATOMIC_RELAXED);
+    }
+    return v;
+}
+
+/* 스레드별 마지막 통계: 다음 통계 루프까지 재사용, 스레드가 끝나면 해제 */
+typedef struct
+{
+    parallel_stats stats;
+    parallel_worker_stats *buf;
+    int cap;
+} stats_store;
+
+static pthread_key_t stats_key;
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+
+static void stats_store_free(void *p)
+{
+    stats_store *st = (stats_store *)p;
+    free(st->buf);
+    free(st);
+}
+
+static void stats_key_init(void)
+{
+    pthread_key_create(&stats_key, stats_store_free);
+}
+
+static stats_store *stats_store_get(void)
+{
+    pthread_once(&stats_once, stats_key_init);
+    stats_store *st = (stats_store *)pthread_getspecific(stats_key);
+    if (!st && (st = (stats_store *)calloc(1, sizeof(*st))) != NULL)
+    {
+        if (pthread_setspecific(stats_key, st) != 0) { free(st); st = NULL; }
+    }
+    return st;
+}
+
+/* 끝난 job 의 통계를 호출 스레드의 마지막 통계로. 시각은 제출 기준으로 바꾼다 */
+static void job_publish_stats(const pfor_job *job)
+{
+    if (!job->stats) return;
+    stats_store *st = stats_store_get();
+    int n = job->nthreads + 1;
+    if (UNLIKELY(!st)) return;
+    if (st->cap < n)
+    {
+        parallel_worker_stats *buf = (parallel_worker_stats *)realloc(st->buf, (size_t)n * sizeof(*buf));
+        if (UNLIKELY(!buf)) return;
+        st->buf = buf;
+        st->cap = n;
+    }
+    long wall = job->t_done - job->t_submit;
+    parallel_perf_counts sum = perf_none;
+    for (int t = 0; t < n; ++t)
+    {
+        parallel_worker_stats w = job->stats[t].s;
+        if (w.first_start_ns >= 0)
+        {
+            w.first_start_ns -= job->t_submit;
+            w.last_finish_ns -= job->t_submit;
+        }
+        w.idle_ns = wall - w.busy_ns;
+        for (int k = 0; k < PERF_N; ++k)
+        {
+            long v = *(const long *)((const char *)&w.perf + perf_field[k]);
+            if (v >= 0) perf_add(&sum, k, v);
+        }
+        st->buf[t] = w;
+    }
+    st->stats = (parallel_stats){ .wall_ns=wall, .nworkers=n, .workers=st->buf, .perf=sum };
+}
+
+int parallel_last_stats(parallel_stats *out)
+{
+    if (UNLIKELY(!out)) return -1;
+    pthread_once(&stats_once, stats_key_init);
+    const stats_store *st = (const stats_store *)pthread_getspecific(stats_key);
+    if (!st || !st->stats.nworkers) return -1;
+    *out = st->stats;
+    return 0;
+}
+
+static void job_free(pfor_job *job)
+{
+    free(job->ranges);
+    free(job->stats);
+}
+
+/* 루프 job 을 채운다. steal / static 은 워커마다 연속 구간 하나씩 나눠 주고,
+ * ext 슬롯은 빈 구간으로 시작해 훔쳐서만 일한다. 성공 0, 할당 실패 -2 */
+static int job_init
+(
+    parallel_pool *pool, pfor_job *job,
+    long begin, long end, long chunk,
+    int options,
+    pfor_range_fn fn,
+    void *userdata
+)
+{
+    if (chunk <= 0) chunk = 1;
+
+    *job = (pfor_job)
+    {
+        .next=begin, .begin=begin, .end=end, .chunk=chunk,
+        .fn=fn, .userdata=userdata, .flags=options,
+        .nthreads=pool->nthreads
+    };
+
+    int sched = options & PARALLEL_OPT_SCHED_MASK;
+    if (sched == PARALLEL_OPT_SCHED_STATIC && pool_self(pool))
+    {
+        // 중첩된 static 은 구간 주인이 바깥 청크에 묶여 있을 수 있다: 누구나 가져가게 steal 로
+        sched = PARALLEL_OPT_SCHED_STEAL;
+        job->flags = (options & ~PARALLEL_OPT_SCHED_MASK) | sched;
+    }
+    if (sched == PARALLEL_OPT_SCHED_STEAL || sched == PARALLEL_OPT_SCHED_STATIC)
+    {
+        int nw = pool->nthreads, nr = nw + 1;
+        void *mem = NULL;
+        if (UNLIKELY(posix_memalign(&mem, 64, (size_t)nr * sizeof(steal_range)) != 0)) return -2;
+        job->ranges  = (steal_range *)mem;
+        job->nranges = nr;
+        long q = (end - begin) / nw, r = (end - begin) % nw;
+        for (int t = 0; t < nw; ++t)
+        {
+            long lo = begin + q * t + branchless_min_long(t, r);
+            job->ranges[t] = (steal_range)
+            {
+                .lock=0, .lo=lo, .hi=lo + q + (t < r)
+            };
+        }
+        job->ranges[nw] = (steal_range){ .lock=0, .lo=end, .hi=end };
+    }
+    int stat_bits = (options & (PARALLEL_OPT_STATS | PARALLEL_OPT_PERF)) | stats_env();
+    if (stat_bits)
+    {
+        job->flags |= stat_bits;
+        int ns = pool->nthreads + 1;
+        void *mem = NULL;
+        if (UNLIKELY(posix_memalign(&mem, 64, (size_t)ns * sizeof(stat_slot)) != 0))
+        {
+            free(job->ranges);
+            return -2;
+        }
+        job->stats = (stat_slot *)mem;
+        for (int t = 0; t < ns; ++t)
+        {
+            job->stats[t].s = (parallel_worker_stats)
+            {
+                .first_start_ns=-1, .last_finish_ns=-1, .cpu=-1, .perf=perf_none
+            };
+        }
+        job->t_submit = now_ns();
+    }
+    return 0;
+}
+
+static int pool_for
+(
+    parallel_pool *pool,
+    long begin, long end, long chunk,
+    int options,
+    pfor_range_fn fn,
+    void *userdata
+)
+{
+    pfor_job job;
+    int rc = job_init(pool, &job, begin, end, chunk, options, fn, userdata);
+    if (UNLIKELY(rc != 0)) return rc;
+    pool_run(pool, &job);
+    job_publish_stats(&job);
+    job_free(&job);
+    return job.cancelled;
+}
+
+void parallel_pool_attr_init(parallel_pool_attr *attr)
+{
+    memset(attr, 0, sizeof(*attr));
+}
+
+parallel_pool *parallel_pool_create_attr(const parallel_pool_attr *attr)
+{
+    if (UNLIKELY(!attr)) return NULL;
+    parallel_pool *pool = (parallel_pool *)malloc(sizeof(*pool));
+    if (UNLIKELY(!pool)) return NULL;
+    if (pool_start(pool, attr) != 0) { free(pool); return NULL; }
+    return pool;
+}
+
+parallel_pool *parallel_pool_create(int nthreads, int options)
+{
+    parallel_pool_attr attr;
+    parallel_pool_attr_init(&attr);
+    attr.nthreads = nthreads;
+    attr.options  = options;
+    return parallel_pool_create_attr(&attr);
+}
+
+int parallel_pool_size(const parallel_pool *pool)
+{
+    return pool ? pool->nthreads : 0;
+}
+
+int parallel_worker_index(void)
+{
+    return tls_worker ? tls_worker->thr_idx : -1;
+}
+
+int parallel_worker_count(void)
+{
+    return tls_worker ? tls_worker->pool->nthreads + 1 : 0;
+}
+
+void *parallel_worker_local(void)
+{
+    return tls_worker ? tls_worker->local : NULL;
+}
+
+int parallel_cancel(void)
+{
+    worker_ctx *self = tls_worker;
+    if (UNLIKELY(!self || !self->job || self->job->kind != JOB_LOOP)) return -1;
+    parallel_pool *pool = self->pool;
+    pthread_mutex_lock(&pool->lock);
+    job_cancel(pool, self->job);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+int parallel_pool_for_range
+(
+    parallel_pool *pool,
+    long begin, long end, long chunk,
+    int options,
+    pfor_range_fn fn,
+    void *userdata
+)
+{
+    if (UNLIKELY(!pool || !fn || end <= begin)) return -1;
+    return pool_for(pool, begin, end, chunk, options, fn, userdata);
+}
+
+int parallel_pool_for_range_sched
+(
+    parallel_pool *pool,
+    long begin, long end, long chunk,
+    int options,
+    const parallel_sched *sched,
+    pfor_range_fn fn,
+    void *userdata
+)
+{
+    if (UNLIKELY(!pool || !fn || end <= begin || (sched && !sched_valid(sched)))) return -1;
+    if (!sched || sched->policy == PARALLEL_SCHED_INHERIT)
+        return pool_for(pool, begin, end, chunk, options, fn, userdata);
+    pfor_job job;
+    int rc = job_init(pool, &job, begin, end, chunk, options, fn, userdata);
+    if (UNLIKELY(rc != 0)) return rc;
+    job.has_sched = 1;
+    job.sched = *sched;
+    pool_run(pool, &job);
+    job_publish_stats(&job);
+    job_free(&job);
+    return job.cancelled;
+}
+
+int parallel_pool_for
+(
+    parallel_pool *pool,
+    long begin, long end, long chunk,
+    int options,
+    pfor_body_fn body,
+    void *userdata
+)
+{
+    if (UNLIKELY(!body)) return -1;
+    body_adapter a = { .body=body, .userdata=userdata };
+    return parallel_pool_for_range(pool, begin, end, chunk, options, body_range, &a);
+}
+
+void parallel_pool_destroy(parallel_pool *pool)
+{
+    if (!pool) return;
+    pool_stop(pool, pool->nthreads);
+    free(pool);
+}
+
+int parallel_for_range
+(
+    long begin, long end, long chunk,
+    int nthreads, int options,
+    pfor_range_fn fn,
+    void *userdata
+)
+{
+    if (UNLIKELY(!fn || end <= begin)) return -1;
+
+    // body 안에서의 호출은 지금 워커의 pool 에 중첩 (스레드를 더 만들지 않는다)
+    if (tls_worker) return pool_for(tls_worker->pool, begin, end, chunk, options, fn, userdata);
+
+    // 일회성 pool: 호출마다 스레드 생성/조인
+    parallel_pool pool;
+    parallel_pool_attr attr;
+    parallel_pool_attr_init(&attr);
+    attr.nthreads = nthreads;
+    attr.options  = options;
+    int rc = pool_start(&pool, &attr);
+    if (UNLIKELY(rc != 0)) return rc;
+    rc = pool_for(&pool, begin, end, chunk, options, fn, userdata);
+    pool_stop(&pool, pool.nthreads);
+    return rc;
+}
+
+int parallel_for
+(
+    long begin, long end, long chunk,
+    int nthreads, int options,
+    pfor_body_fn body,
+    void *userdata
+)
+{
+    if (UNLIKELY(!body)) return -1;
+    body_adapter a = { .body=body, .userdata=userdata };
+    return parallel_for_range(begin, end, chunk, nthreads, options, body_range, &a);
+}
+
+/* 리덕션: [begin, end) 를 n 과 chunk 로만 정해지는 블록으로 나누고 블록마다 64B 정렬 슬롯 하나.
+ * 어느 워커가 어떤 블록을 돌든 슬롯 내용이 같으므로, 블록 순서대로 합친 결과는 스레드 수나
+ * 스케줄과 상관없이 같다 */
+#ifndef PARALLEL_REDUCE_MAX_BLOCKS
+#  define PARALLEL_REDUCE_MAX_BLOCKS 1024
+#endif
+#define REDUCE_SLOT_BYTES (1L << 20)    // 큰 acc 는 블록 수를 줄여 슬롯 전체를 이만큼으로
+
+typedef struct
+{
+    preduce_map_fn map;
+    void *userdata;
+    unsigned char *slots;
+    size_t stride;
+    long begin, end, block;
+} reduce_ctx;
+
+static void reduce_range(long start, long stop, void *arg)
+{
+    const reduce_ctx *r = (const reduce_ctx *)arg;
+    for (long b = start; b < stop; ++b)
+    {
+        long lo = r->begin + b * r->block;
+        long hi = r->end - lo > r->block ? lo + r->block : r->end;
+        r->map(lo, hi, r->slots + (size_t)b * r->stride, r->userdata);
+    }
+}
+
+static int pool_reduce
+(
+    parallel_pool *pool,
+    long begin, long end, long chunk,
+    int options,
+    const void *identity, size_t size,
+    preduce_map_fn map, preduce_combine_fn combine,
+    void *userdata, void *result
+)
+{
+    size_t stride = (size + 63) & ~(size_t)63;
+    long maxb = REDUCE_SLOT_BYTES / (long)stride;
+    if (maxb > PARALLEL_REDUCE_MAX_BLOCKS) maxb = PARALLEL_REDUCE_MAX_BLOCKS;
+    if (maxb < 64) maxb = 64;
+    const long n = end - begin;
+    long block = (n + maxb - 1) / maxb;
+    if (block < chunk) block = chunk;
+    const long nblocks = (n + block - 1) / block;
+
+    void *mem = NULL;
+    if (UNLIKELY(posix_memalign(&mem, 64, (size_t)nblocks * stride) != 0)) return -2;
+    reduce_ctx r = { .map=map, .userdata=userdata, .slots=(unsigned char *)mem, .stride=stride,
+                     .begin=begin, .end=end, .block=block };
+    for (long b = 0; b < nblocks; ++b) memcpy(r.slots + (size_t)b * stride, identity, size);
+
+    int rc = pool_for(pool, 0, nblocks, 1, options, reduce_range, &r);
+    if (rc >= 0)
+    {
+        // 블록 (= 범위) 순서대로: combine 은 결합법칙만 있으면 되고 부동소수점 결과도 재현된다
+        memcpy(result, identity, size);
+        for (long b = 0; b < nblocks; ++b) combine(result, r.slots + (size_t)b * stride, userdata);
+    }
+    free(mem);
+    return rc;
+}
+
+int parallel_pool_reduce
+(
+    parallel_pool *pool,
+    long begin, long end, long chunk,
+    int options,
+    const void *identity, size_t size,
+    preduce_map_fn map, preduce_combine_fn combine,
+    void *userdata, void *result
+)
+{
+    if (UNLIKELY(!pool || !identity || !size || !map || !combine || !result)) return -1;
+    if (end <= begin) { memcpy(result, identity, size); return 0; }
+    return pool_reduce(pool, begin, end, chunk, options, identity, size, map, combine, userdata, result);
+}
+
+int parallel_reduce
+(
+    long begin, long end, long chunk,
+    int nthreads, int options,
+    const void *identity, size_t size,
+    preduce_map_fn map, preduce_combine_fn combine,
+    void *userdata, void *result
+)
+{
+    if (UNLIKELY(!identity || !size || !map || !combine || !result)) return -1;
+    if (end <= begin) { memcpy(result, identity, size); return 0; }
+    if (tls_worker)
+        return pool_reduce(tls_worker->pool, begin, end, chunk, options,
+                           identity, size, map, combine, userdata, result);
+
+    parallel_pool pool;
+    parallel_pool_attr attr;
+    parallel_pool_attr_init(&attr);
+    attr.nthreads = nthreads;
+    attr.options  = options;
+    int rc = pool_start(&pool, &attr);
+    if (UNLIKELY(rc != 0)) return rc;
+    rc = pool_reduce(&pool, begin, end, chunk, options, identity, size, map, combine, userdata, result);
+    pool_stop(&pool, pool.nthreads);
+    return rc;
+}
+
+/* find_first: shared 스케줄은 청크를 앞에서부터 순서대로 나눠 주므로, 맞는 i 를 찾은 순간
+ * i 보다 앞의 청크는 이미 누군가 들고 있다. 나머지를 cancel 하고 들고 있는 청크만 끝낸다 */
+typedef struct
+{
+    pfind_pred_fn pred;
+    void *userdata;
+    long best;          // 지금까지 찾은 가장 작은 i, 없으면 end
+} find_ctx;
+
+static void find_range(long start, long stop, void *arg)
+{
+    find_ctx *c = (find_ctx *)arg;
+    if (start >= __atomic_load_n(&c->best, __ATOMIC_RELAXED)) return;
+    for (long i = start; i < stop; ++i)
+    {
+        if (!c->pred(i, c->userdata)) continue;
+        long cur = __atomic_load_n(&c->best, __ATOMIC_RELAXED);
+        while (i < cur && !__atomic_compare_exchange_n(&c->best, &cur, i, 0,
+                                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+        parallel_cancel();
+        return;
+    }
+}
+
+static int pool_find_first
+(
+    parallel_pool *pool,
+    long begin, long end, long chunk,
+    int options,
+    pfind_pred_fn pred, void *userdata,
+    long *index
+)
+{
+    find_ctx c = { .pred=pred, .userdata=userdata, .best=end };
+    options = (options & ~PARALLEL_OPT_SCHED_MASK) | PARALLEL_OPT_SCHED_SHARED;
+    int rc = pool_for(pool, begin, end, chunk, options, find_range, &c);
+    if (UNLIKELY(rc < 0)) return rc;
+    *index = c.best;
+    return 0;
+}
+
+int parallel_pool_find_first
+(
+    parallel_pool *pool,
+    long begin, long end, long chunk,
+    int options,
+    pfind_pred_fn pred, void *userdata,
+    long *index
+)
+{
+    if (UNLIKELY(!pool || !pred || !index)) return -1;
+    if (end <= begin) { *index = end; return 0; }
+    return pool_find_first(pool, begin, end, chunk, options, pred, userdata, index);
+}
+
+int parallel_find_first
+(
+    long begin, long end, long chunk,
+    int nthreads, int options,
+    pfind_pred_fn pred, void *userdata,
+    long *index
+)
+{
+    if (UNLIKELY(!pred || !index)) return -1;
+    if (end <= begin) { *index = end; return 0; }
+    if (tls_worker)
+        return pool_find_first(tls_worker->pool, begin, end, chunk, options, pred, userdata, index);
+
+    parallel_pool pool;
+    parallel_pool_attr attr;
+    parallel_pool_attr_init(&attr);
+    attr.nthreads = nthreads;
+    attr.options  = options;
+    int rc = pool_start(&pool, &attr);
+    if (UNLIKELY(rc != 0)) return rc;
+    rc = pool_find_first(&pool, begin, end, chunk, options, pred, userdata, index);
+    pool_stop(&pool, pool.nthreads);
+    return rc;
+}
+
+/* 스캔: 블록 경계는 chunk 로 고정 (스케줄과 무관하게 결합 순서가 같다).
+ * 1 단계는 블록마다 합만 (reduce), 블록 합을 직렬로 스캔해 시작값을 얻고,
+ * 2 단계에서 블록마다 시작값부터 스캔하며 out 에 쓴다. in 은 두 번 읽고 out 은 한 번만 쓴다 */
+#define SCAN_MIN_BLOCK 4096L
+
+typedef struct
+{
+    const unsigned char *in;
+    unsigned char *out;
+    long n, block;
+    size_t size, stride;
+    preduce_combine_fn op;      // NULL 이면 long 덧셈
+    void *userdata;
+    int inclusive;
+    unsigned char *sums;        // 블록마다 stride 간격: 1 단계 합 → 시작값 → 2 단계 끝값
+    unsigned char *scratch;     // 워커마다 stride: exclusive 제자리 스캔의 임시 원소
+} scan_ctx;
+
+static void scan_reduce_block(const scan_ctx *c, long b)
+{
+    long lo = b * c->block, hi = lo + c->block < c->n ? lo + c->block : c->n;
+    void *acc = c->sums + (size_t)b * c->stride;
+    if (!c->op)
+    {
+        const long *in = (const long *)c->in;
+        unsigned long s = *(const unsigned long *)acc;     // 넘침은 2 의 보수로 감는다
+        for (long i = lo; i < hi; ++i) s += (unsigned long)in[i];
+        *(unsigned long *)acc = s;
+        return;
+    }
+    for (long i = lo; i < hi; ++i) c->op(acc, c->in + (size_t)i * c->size, c->userdata);
+}
+
+static void scan_apply_block(const scan_ctx *c, long b, void *tmp)
+{
+    long lo = b * c->block, hi = lo + c->block < c->n ? lo + c->block : c->n;
+    void *acc = c->sums + (size_t)b * c->stride;
+    if (!c->op)
+    {
+        const long *in = (const long *)c->in;
+        long *out = (long *)c->out;
+        unsigned long s = *(const unsigned long *)acc;
+        if (c->inclusive)
+            for (long i = lo; i < hi; ++i) { s += (unsigned long)in[i]; out[i] = (long)s; }
+        else
+            for (long i = lo; i < hi; ++i) { unsigned long x = (unsigned long)in[i]; out[i] = (long)s; s += x; }
+        *(unsigned long *)acc = s;
+        return;
+    }
+    for (long i = lo; i < hi; ++i)
+    {
+        const void *x = c->in + (size_t)i * c->size;
+        void *y = c->out + (size_t)i * c->size;
+        if (c->inclusive) { c->op(acc, x, c->userdata); memcpy(y, acc, c->size); continue; }
+        memcpy(tmp, x, c->size);        // in == out 이면 덮어쓰기 전에
+        memcpy(y, acc, c->size);
+        c->op(acc, tmp, c->userdata);
+    }
+}
+
+static void scan_reduce_range(long start, long stop, void *arg)
+{
+    const scan_ctx *c = (const scan_ctx *)arg;
+    for (long b = start; b < stop; ++b) scan_reduce_block(c, b);
+}
+
+static void scan_apply_range(long start, long stop, void *arg)
+{
+    const scan_ctx *c = (const scan_ctx *)arg;
+    void *tmp = c->scratch + (size_t)tls_worker->thr_idx * c->stride;
+    for (long b = start; b < stop; ++b) scan_apply_block(c, b, tmp);
+}
+
+static int pool_scan
+(
+    parallel_pool *pool,
+    const void *in, void *out, long n, long chunk,
+    int options,
+    const void *identity, size_t size,
+    preduce_combine_fn op, void *userdata,
+    void *total
+)
+{
+    int nslots = pool->nthreads + 1;     // + ext 슬롯
+    if (chunk <= 0)
+    {
+        // 워커당 블록 4 개쯤, 너무 잘면 블록 합 직렬 스캔과 분배 비용이 커진다
+        chunk = (n + 4L * nslots - 1) / (4L * nslots);
+        if (chunk < SCAN_MIN_BLOCK) chunk = SCAN_MIN_BLOCK;
+    }
+    long nblocks = (n + chunk - 1) / chunk;
+    size_t stride = (size + 63) & ~(size_t)63;
+    void *mem = NULL;
+    if (UNLIKELY(posix_memalign(&mem, 64, ((size_t)nblocks + (size_t)nslots) * stride) != 0)) return -2;
+
+    scan_ctx c = { .in=(const unsigned char *)in, .out=(unsigned char *)out, .n=n, .block=chunk,
+                   .size=size, .stride=stride, .op=op, .userdata=userdata,
+                   .inclusive=(options & PARALLEL_OPT_SCAN_INCLUSIVE) != 0,
+                   .sums=(unsigned char *)mem, .scratch=(unsigned char *)mem + (size_t)nblocks * stride };
+    options &= ~PARALLEL_OPT_SCAN_INCLUSIVE;
+    for (long b = 0; b < nblocks; ++b) memcpy(c.sums + (size_t)b * stride, identity, size);
+
+    int rc = 0;
+    if (nblocks == 1)
+    {
+        // 블록 하나: 1 단계 없이 호출 스레드에서
+        scan_apply_block(&c, 0, c.scratch);
+    }
+    else
+    {
+        rc = pool_for(pool, 0, nblocks, 1, options, scan_reduce_range, &c);
+        if (UNLIKELY(rc != 0)) { free(mem); return rc; }
+
+        // 블록 합 → 블록 시작값 (exclusive). 워커 scratch 두 칸을 빌려 쓴다 (nslots >= 2)
+        void *run = c.scratch, *tmp = c.scratch + stride;
+        memcpy(run, identity, size);
+        for (long b = 0; b < nblocks; ++b)
+        {
+            void *s = c.sums + (size_t)b * stride;
+            memcpy(tmp, s, size);
+            memcpy(s, run, size);
+            if (op) op(run, tmp, userdata);
+            else    *(unsigned long *)run += *(const unsigned long *)tmp;
+        }
+        rc = pool_for(pool, 0, nblocks, 1, options, scan_apply_range, &c);
+    }
+    if (rc >= 0 && total) memcpy(total, c.sums + (size_t)(nblocks - 1) * stride, size);
+    free(mem);
+    return rc;
+}
+
+static int scan_entry
+(
+    parallel_pool *pool, int nthreads,
+    const void *in, void *out, long n, long chunk,
+    int options,
+    const void *identity, size_t size,
+    preduce_combine_fn op, void *userdata,
+    void *total
+)
+{
+    if (n <= 0) { if (total) memcpy(total, identity, size); return 0; }
+    if (pool)       return pool_scan(pool, in, out, n, chunk, options, identity, size, op, userdata, total);
+    if (tls_worker) return pool_scan(tls_worker->pool, in, out, n, chunk, options, identity, size, op, userdata, total);
+
+    parallel_pool own;
+    parallel_pool_attr attr;
+    parallel_pool_attr_init(&attr);
+    attr.nthreads = nthreads;
+    attr.options  = options & ~PARALLEL_OPT_SCAN_INCLUSIVE;
+    int rc = pool_start(&own, &attr);
+    if (UNLIKELY(rc != 0)) return rc;
+    rc = pool_scan(&own, in, out, n, chunk, options, identity, size, op, userdata, total);
+    pool_stop(&own, own.nthreads);
+    return rc;
+}
+
+int parallel_pool_scan
+(
+    parallel_pool *pool,
+    const void *in, void *out, long n, long chunk,
+    int options,
+    const void *identity, size_t size,
+    preduce_combine_fn op, void *userdata,
+    void *total
+)
+{
+    if (UNLIKELY(!pool || !identity || !size || !op || (n > 0 && (!in || !out)))) return -1;
+    return scan_entry(pool, 0, in, out, n, chunk, options, identity, size, op, userdata, total);
+}
+
+int parallel_scan
+(
+    const void *in, void *out, long n, long chunk,
+    int nthreads, int options,
+    const void *identity, size_t size,
+    preduce_combine_fn op, void *userdata,
+    void *total
+)
+{
+    if (UNLIKELY(!identity || !size || !op || (n > 0 && (!in || !out)))) return -1;
+    return scan_entry(NULL, nthreads, in, out, n, chunk, options, identity, size, op, userdata, total);
+}
+
+int parallel_pool_scan_long
+(
+    parallel_pool *pool,
+    const long *in, long *out, long n, long chunk,
+    int options, long *total
+)
+{
+    static const long zero = 0;
+    if (UNLIKELY(!pool || (n > 0 && (!in || !out)))) return -1;
+    return scan_entry(pool, 0, in, out, n, chunk, options, &zero, sizeof(long), NULL, NULL, total);
+}
+
+int parallel_scan_long
+(
+    const long *in, long *out, long n, long chunk,
+    int nthreads, int options, long *total
+)
+{
+    static const long zero = 0;
+    if (UNLIKELY(n > 0 && (!in || !out))) return -1;
+    return scan_entry(NULL, nthreads, in, out, n, chunk, options, &zero, sizeof(long), NULL, NULL, total);
+}
+
+/* 태스크 그룹: 큐에 올라간 JOB_TASKS job 하나. spawn 할 때 큐에서 빠져 있으면 다시 올린다 */
+parallel_task_group *parallel_task_group_create(parallel_pool *pool)
+{
+    if (!pool && tls_worker) pool = tls_worker->pool;
+    if (UNLIKELY(!pool)) return NULL;
+    parallel_task_group *g = (parallel_task_group *)calloc(1, sizeof(*g));
+    if (UNLIKELY(!g)) return NULL;
+    worker_ctx *self = pool_self(pool);
+    g->pool = pool;
+    g->job.kind = JOB_TASKS;
+    g->job.nthreads = pool->nthreads;
+    g->job.depth = self ? self->depth + 1 : 0;
+    g->job.exhausted = 1;   // 태스크가 생기기 전엔 큐에 없다
+    g->job.done = 1;
+    return g;
+}
+
+int parallel_task_spawn(parallel_task_group *group, ptask_fn fn, void *arg)
+{
+    if (UNLIKELY(!group || !fn)) return -1;
+    ptask *t = (ptask *)malloc(sizeof(*t));
+    if (UNLIKELY(!t)) return -2;
+    *t = (ptask){ .fn=fn, .arg=arg, .next=NULL };
+
+    parallel_pool *pool = group->pool;
+    pfor_job *job = &group->job;
+    pthread_mutex_lock(&pool->lock);
+    if (job->tasks_tail) job->tasks_tail->next = t;
+    else                 job->tasks = t;
+    job->tasks_tail = t;
+    job->done = 0;
+    if (job->exhausted)
+    {
+        job->exhausted = 0;
+        job_enqueue(pool, job);
+    }
+    else
+    {
+        event_kick(&pool->wake, 1);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+int parallel_task_group_wait(parallel_task_group *group)
+{
+    if (UNLIKELY(!group)) return -1;
+    parallel_pool *pool = group->pool;
+    pthread_mutex_lock(&pool->lock);
+    pool_wait(pool, &group->job);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+void parallel_task_group_destroy(parallel_task_group *group)
+{
+    if (!group) return;
+    parallel_task_group_wait(group);
+    free(group);
+}
+
+/* 비동기 루프: pool 이 NULL 이면 워커 안에선 그 pool, 밖에선 future 가 들고 있는 일회성 pool */
+static parallel_future *future_start
+(
+    parallel_pool *pool, int nthreads,
+    long begin, long end, long chunk,
+    int options,
+    pfor_range_fn fn, pfor_body_fn body,
+    void *userdata
+)
+{
+    if (UNLIKELY((!fn && !body) || end <= begin)) return NULL;
+    void *mem = NULL;
+    if (UNLIKELY(posix_memalign(&mem, 64, sizeof(parallel_future)) != 0)) return NULL;
+    parallel_future *f = (parallel_future *)mem;
+    memset(f, 0, sizeof(*f));
+
+    if (body)
+    {
+        f->adapter = (body_adapter){ .body=body, .userdata=userdata };
+        fn = body_range;
+        userdata = &f->adapter;
+    }
+    if (!pool && tls_worker) pool = tls_worker->pool;
+    if (!pool)
+    {
+        parallel_pool_attr attr;
+        parallel_pool_attr_init(&attr);
+        attr.nthreads = nthreads;
+        attr.options  = options;
+        if (UNLIKELY(pool_start(&f->owned, &attr) != 0)) { free(f); return NULL; }
+        f->owns_pool = 1;
+        pool = &f->owned;
+    }
+    f->pool = pool;
+
+    if (UNLIKELY(job_init(pool, &f->job, begin, end, chunk, options, fn, userdata) != 0))
+    {
+        if (f->owns_pool) pool_stop(pool, pool->nthreads);
+        free(f);
+        return NULL;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool_submit(pool, &f->job);
+    pthread_mutex_unlock(&pool->lock);
+    return f;
+}
+
+parallel_future *parallel_for_async
+(
+    long begin, long end, long chunk,
+    int nthreads, int options,
+    pfor_body_fn body,
+    void *userdata
+)
+{
+    if (UNLIKELY(!body)) return NULL;
+    return future_start(NULL, nthreads, begin, end, chunk, options, NULL, body, userdata);
+}
+
+parallel_future *parallel_for_range_async
+(
+    long begin, long end, long chunk,
+    int nthreads, int options,
+    pfor_range_fn fn,
+    void *userdata
+)
+{
+    if (UNLIKELY(!fn)) return NULL;
+    return future_start(NULL, nthreads, begin, end, chunk, options, fn, NULL, userdata);
+}
+
+parallel_future *parallel_pool_for_async
+(
+    parallel_pool *pool,
+    long begin, long end, long chunk,
+    int options,
+    pfor_body_fn body,
+    void *userdata
+)
+{
+    if (UNLIKELY(!pool || !body)) return NULL;
+    return future_start(pool, 0, begin, end, chunk, options, NULL, body, userdata);
+}
+
+parallel_future *parallel_pool_for_range_async
+(
+    parallel_pool *pool,
+    long begin, long end, long chunk,
+    int options,
+    pfor_range_fn fn,
+    void *userdata
+)
+{
+    if (UNLIKELY(!pool || !fn)) return NULL;
+    return future_start(pool, 0, begin, end, chunk, options, fn, NULL, userdata);
+}
+
+int parallel_future_test(parallel_future *f)
+{
+    if (UNLIKELY(!f)) return -1;
+    pthread_mutex_lock(&f->pool->lock);
+    int done = f->job.done;
+    pthread_mutex_unlock(&f->pool->lock);
+    return done;
+}
+
+int parallel_future_wait(parallel_future *f, int help)
+{
+    if (UNLIKELY(!f)) return -1;
+    parallel_pool *pool = f->pool;
+    pthread_mutex_lock(&pool->lock);
+    if (help && !pool_self(pool)) pool_help(pool, &f->job);
+    else                          pool_wait(pool, &f->job);
+    int cancelled = f->job.cancelled;
+    pthread_mutex_unlock(&pool->lock);
+    job_publish_stats(&f->job);
+    return cancelled;
+}
+
+int parallel_future_cancel(parallel_future *f)
+{
+    if (UNLIKELY(!f)) return -1;
+    pthread_mutex_lock(&f->pool->lock);
+    job_cancel(f->pool, &f->job);
+    pthread_mutex_unlock(&f->pool->lock);
+    return 0;
+}
+
+void parallel_future_destroy(parallel_future *f)
+{
+    if (!f) return;
+    parallel_future_wait(f, 0);
+    job_free(&f->job);
+    if (f->owns_pool) pool_stop(&f->owned, f->owned.nthreads);
+    free(f);
 }
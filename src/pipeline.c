@@ -0,0 +1,218 @@
+/* pipeline.c — parallel_pipeline.h: 태스크 그룹 위의 단계별 item 흐름 */
+#define _GNU_SOURCE
+#include "parallel_pipeline.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    ppipe_stage_fn fn;
+    void *userdata;
+    int serial;
+    long queue;         // 입력 큐 한도, <= 0 이면 없음
+    long waiting;       // 앞 단계를 끝내고 이 단계를 기다리는 item
+    long running;
+    long next;          // SERIAL: 다음 차례 item
+} pstage;
+
+/* window 칸 링: item i 는 칸 i % window. 한 item 은 한 번에 한 단계에만 있다 */
+typedef struct
+{
+    parallel_pipeline *pp;
+    long item;
+    int stage;          // 다음에 돌 (또는 돌고 있는) 단계, -1 이면 빈 칸
+    int busy;
+} pslot;
+
+struct parallel_pipeline
+{
+    pthread_mutex_t mu;
+    parallel_task_group *group;
+    pstage *stages;
+    int nstages, cap;
+    long window;
+    pslot *slots;
+    long nitems;        // < 0 이면 아직 모름
+    long next_item;     // 다음에 들일 item
+    long oldest;        // 가장 오래된 미완료 item
+    long completed;
+    int rc;
+};
+
+parallel_pipeline *parallel_pipeline_create(parallel_pool *pool, long window)
+{
+    if (window <= 0)
+    {
+        int workers = pool ? parallel_pool_size(pool) + 1 : parallel_worker_count();
+        window = 4L * (workers > 0 ? workers : 1);
+    }
+    parallel_pipeline *pp = (parallel_pipeline *)calloc(1, sizeof(*pp));
+    if (!pp) return NULL;
+    pp->window = window;
+    pp->slots = (pslot *)calloc((size_t)window, sizeof(pslot));
+    pp->group = pp->slots ? parallel_task_group_create(pool) : NULL;
+    if (!pp->group) { free(pp->slots); free(pp); return NULL; }
+    pthread_mutex_init(&pp->mu, NULL);
+    return pp;
+}
+
+int parallel_pipeline_add_stage(parallel_pipeline *pp, ppipe_stage_fn fn, void *userdata,
+                                int flags, long queue)
+{
+    if (!pp || !fn) return -1;
+    if (pp->nstages == pp->cap)
+    {
+        int cap = pp->cap ? 2 * pp->cap : 4;
+        pstage *s = (pstage *)realloc(pp->stages, (size_t)cap * sizeof(pstage));
+        if (!s) return -2;
+        pp->stages = s;
+        pp->cap = cap;
+    }
+    pp->stages[pp->nstages] = (pstage){ .fn=fn, .userdata=userdata,
+                                        .serial=(flags & PARALLEL_STAGE_SERIAL) != 0, .queue=queue };
+    return pp->nstages++;
+}
+
+static void stage_task(void *arg);
+
+/* item 이 단계 s 를 시작해도 되나: 다음 단계 큐 자리 (가장 오래된 item 은 예외) */
+static int room_after(const parallel_pipeline *pp, int s, long item)
+{
+    if (s + 1 >= pp->nstages || item == pp->oldest) return 1;
+    const pstage *nx = &pp->stages[s + 1];
+    return nx->queue <= 0 || nx->waiting + pp->stages[s].running < nx->queue;
+}
+
+static int start(parallel_pipeline *pp, pslot *sl, int s)
+{
+    pstage *st = &pp->stages[s];
+    sl->busy = 1;
+    st->running++;
+    if (parallel_task_spawn(pp->group, stage_task, sl) == 0) return 0;
+    sl->busy = 0;
+    st->running--;
+    if (!pp->rc) pp->rc = -2;
+    return -1;
+}
+
+/* 잠금 안에서: 시작할 수 있는 것을 모두 태스크로. 뒤 단계부터 비워야 큐가 빨리 빠진다 */
+static void pump(parallel_pipeline *pp)
+{
+    for (int s = pp->nstages - 1; s >= 0 && !pp->rc; --s)
+    {
+        pstage *st = &pp->stages[s];
+        if (s == 0)
+        {
+            while (!pp->rc && (pp->nitems < 0 || pp->next_item < pp->nitems)
+                   && pp->next_item - pp->oldest < pp->window
+                   && !(st->serial && st->running) && room_after(pp, 0, pp->next_item))
+            {
+                pslot *sl = &pp->slots[pp->next_item % pp->window];
+                *sl = (pslot){ .pp=pp, .item=pp->next_item, .stage=0 };
+                pp->next_item++;
+                if (start(pp, sl, 0) != 0) { sl->stage = -1; pp->next_item--; }
+            }
+            continue;
+        }
+        if (!st->waiting || (st->serial && st->running)) continue;
+        // 번호 순으로 훑는다: 작은 item 이 먼저
+        for (long i = pp->oldest; i < pp->next_item && st->waiting && !pp->rc; ++i)
+        {
+            pslot *sl = &pp->slots[i % pp->window];
+            if (sl->stage != s || sl->busy) continue;
+            if (st->serial && i != st->next) break;
+            if (!room_after(pp, s, i)) break;
+            st->waiting--;
+            if (start(pp, sl, s) != 0) { st->waiting++; break; }
+            if (st->serial) break;
+        }
+    }
+}
+
+static void finish_item(parallel_pipeline *pp, pslot *sl)
+{
+    sl->stage = -1;
+    while (pp->oldest < pp->next_item && pp->slots[pp->oldest % pp->window].stage < 0) pp->oldest++;
+}
+
+static void stage_task(void *arg)
+{
+    pslot *sl = (pslot *)arg;
+    parallel_pipeline *pp = sl->pp;
+    const long item = sl->item;
+    const int s = sl->stage;
+    pstage *st = &pp->stages[s];
+    int r = st->fn(item, st->userdata);
+
+    pthread_mutex_lock(&pp->mu);
+    st->running--;
+    sl->busy = 0;
+    if (st->serial) st->next = item + 1;
+    if (s == 0 && r == PARALLEL_PIPELINE_STOP)
+    {
+        // 입력 끝: 이 item 부터는 없다 (SERIAL 이 아닌 첫 단계면 뒤 item 이 이미 떠 있을 수 있다)
+        if (pp->nitems < 0 || item < pp->nitems) pp->nitems = item;
+        r = 0;
+    }
+    if (r != 0 && !pp->rc) pp->rc = r;
+    if (r != 0 || s + 1 == pp->nstages || (pp->nitems >= 0 && item >= pp->nitems))
+    {
+        if (r == 0 && s + 1 == pp->nstages && (pp->nitems < 0 || item < pp->nitems)) pp->completed++;
+        finish_item(pp, sl);
+    }
+    else
+    {
+        sl->stage = s + 1;
+        pp->stages[s + 1].waiting++;
+    }
+    // 버려진 item 들이 기다리던 자리도 치운다
+    if (pp->nitems >= 0 && pp->next_item > pp->nitems)
+        for (long i = pp->oldest; i < pp->next_item; ++i)
+        {
+            pslot *o = &pp->slots[i % pp->window];
+            if (i < pp->nitems || o->stage < 0 || o->busy) continue;
+            pp->stages[o->stage].waiting--;
+            finish_item(pp, o);
+        }
+    pump(pp);
+    pthread_mutex_unlock(&pp->mu);
+}
+
+int parallel_pipeline_run(parallel_pipeline *pp, long nitems)
+{
+    if (!pp || !pp->nstages) return -1;
+    pthread_mutex_lock(&pp->mu);
+    pp->nitems = nitems;
+    pp->next_item = pp->oldest = pp->completed = 0;
+    pp->rc = 0;
+    for (int s = 0; s < pp->nstages; ++s)
+    {
+        pp->stages[s].waiting = pp->stages[s].running = 0;
+        pp->stages[s].next = 0;
+    }
+    for (long i = 0; i < pp->window; ++i) pp->slots[i].stage = -1;
+    pump(pp);
+    pthread_mutex_unlock(&pp->mu);
+
+    parallel_task_group_wait(pp->group);
+    pthread_mutex_lock(&pp->mu);
+    int rc = pp->rc;
+    pthread_mutex_unlock(&pp->mu);
+    return rc;
+}
+
+long parallel_pipeline_completed(const parallel_pipeline *pp)
+{
+    return pp ? pp->completed : 0;
+}
+
+void parallel_pipeline_destroy(parallel_pipeline *pp)
+{
+    if (!pp) return;
+    parallel_task_group_destroy(pp->group);
+    pthread_mutex_destroy(&pp->mu);
+    free(pp->stages);
+    free(pp->slots);
+    free(pp);
+}
@@ -0,0 +1,336 @@
+/* sort.c — parallel_sort.h: 병합 정렬 (merge path 분할) + 정수 키 LSD radix */
+#define _GNU_SOURCE
+#include "parallel_sort.h"
+#include "parallel_array.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RADIX_BITS        8
+#define RADIX_DIGITS      (1 << RADIX_BITS)
+#define RADIX_BLOCK       (64L << 10)   // 블록 하나의 키 수 (목표)
+#define RADIX_MAX_BLOCKS  256           // 히스토그램 = 256 x 블록 수 x long
+#define MSORT_INSERTION   16
+
+/* ---- 실행: pool 이 있으면 그 위에서, 없으면 지금 워커의 pool 에 중첩, serial 이면 호출 스레드 ---- */
+typedef struct
+{
+    parallel_pool *pool;
+    parallel_pool *own;     // 정렬 동안만 만든 pool
+    int options;
+    int serial;
+} runner;
+
+static int runner_init(runner *r, parallel_pool *pool, size_t n, int options)
+{
+    *r = (runner){ .pool=pool, .options=options, .serial=n < PARALLEL_SORT_SERIAL_CUTOFF };
+    if (r->serial || pool || parallel_worker_index() >= 0) return 0;
+    r->own = r->pool = parallel_pool_create(0, options);
+    return r->own ? 0 : -3;
+}
+
+static void runner_fini(runner *r)
+{
+    parallel_pool_destroy(r->own);
+}
+
+static int runner_for(const runner *r, long n, pfor_range_fn fn, void *ctx)
+{
+    if (r->serial) { fn(0, n, ctx); return 0; }
+    if (r->pool) return parallel_pool_for_range(r->pool, 0, n, 1, r->options, fn, ctx);
+    return parallel_for_range(0, n, 1, 0, r->options, fn, ctx);
+}
+
+static int runner_workers(const runner *r)
+{
+    if (r->serial) return 1;
+    return r->pool ? parallel_pool_size(r->pool) + 1 : parallel_worker_count();
+}
+
+static long radix_blocks(size_t n)
+{
+    long nb = (long)((n + RADIX_BLOCK - 1) / RADIX_BLOCK);
+    if (nb < 1) nb = 1;
+    return nb > RADIX_MAX_BLOCKS ? RADIX_MAX_BLOCKS : nb;
+}
+
+size_t parallel_sort_scratch_size(size_t n, size_t size)
+{
+    // 키 n 개 + (radix 면) 정렬된 히스토그램
+    return ((n * size + 63) & ~(size_t)63) + 64 + (size_t)RADIX_DIGITS * (size_t)radix_blocks(n) * sizeof(long);
+}
+
+/* ---- 병합 정렬 ---- */
+typedef struct
+{
+    size_t size;
+    psort_cmp_fn cmp;
+    void *userdata;
+} elem_ops;
+
+#define AT(p, i, sz) ((unsigned char *)(p) + (size_t)(i) * (sz))
+
+/* 흔한 크기는 상수 memcpy 로 (한 원소마다 libc 호출이 비교보다 비쌌다) */
+static inline void copy_elem(void *d, const void *s, size_t sz)
+{
+    switch (sz)
+    {
+    case 4:  memcpy(d, s, 4); break;
+    case 8:  memcpy(d, s, 8); break;
+    case 16: memcpy(d, s, 16); break;
+    default: memcpy(d, s, sz); break;
+    }
+}
+
+/* a, b 를 out 으로. 같으면 a 먼저 (안정) */
+static void merge_runs(const elem_ops *e, const unsigned char *a, size_t na,
+                       const unsigned char *b, size_t nb, unsigned char *out)
+{
+    const size_t sz = e->size;
+    while (na && nb)
+    {
+        if (e->cmp(a, b, e->userdata) <= 0) { copy_elem(out, a, sz); a += sz; --na; }
+        else                                { copy_elem(out, b, sz); b += sz; --nb; }
+        out += sz;
+    }
+    if (na) memcpy(out, a, na * sz);
+    if (nb) memcpy(out, b, nb * sz);
+}
+
+/* merge path: a, b 병합의 앞쪽 k 개 중 a 에서 오는 개수 */
+static size_t co_rank(const elem_ops *e, const unsigned char *a, size_t na,
+                      const unsigned char *b, size_t nb, size_t k)
+{
+    size_t lo = k > nb ? k - nb : 0, hi = k < na ? k : na;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (e->cmp(AT(a, mid, e->size), AT(b, k - mid - 1, e->size), e->userdata) <= 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/* 한 스레드: 16 개씩 삽입 정렬 후 base ↔ tmp 를 오가며 bottom-up 병합, 결과는 base */
+static void serial_msort(const elem_ops *e, unsigned char *base, unsigned char *tmp, size_t n)
+{
+    const size_t sz = e->size;
+    for (size_t lo = 0; lo < n; lo += MSORT_INSERTION)
+    {
+        size_t hi = lo + MSORT_INSERTION < n ? lo + MSORT_INSERTION : n;
+        for (size_t i = lo + 1; i < hi; ++i)
+        {
+            size_t j = i;
+            copy_elem(tmp, AT(base, i, sz), sz);
+            while (j > lo && e->cmp(AT(base, j - 1, sz), tmp, e->userdata) > 0) --j;
+            if (j == i) continue;
+            memmove(AT(base, j + 1, sz), AT(base, j, sz), (i - j) * sz);
+            copy_elem(AT(base, j, sz), tmp, sz);
+        }
+    }
+    unsigned char *src = base, *dst = tmp;
+    for (size_t w = MSORT_INSERTION; w < n; w *= 2)
+    {
+        for (size_t lo = 0; lo < n; lo += 2 * w)
+        {
+            size_t mid = lo + w < n ? lo + w : n, hi = lo + 2 * w < n ? lo + 2 * w : n;
+            merge_runs(e, AT(src, lo, sz), mid - lo, AT(src, mid, sz), hi - mid, AT(dst, lo, sz));
+        }
+        unsigned char *t = src; src = dst; dst = t;
+    }
+    if (src != base) memcpy(base, src, n * sz);
+}
+
+typedef struct
+{
+    elem_ops e;
+    unsigned char *base, *tmp;      // 이번 단계 src / dst
+    size_t n;
+    long nruns, width, tp;          // run 수 (2 의 거듭제곱), 짝 하나의 run 수 / 2, 짝 하나의 조각 수
+} msort_ctx;
+
+static size_t run_start(const msort_ctx *c, long k)
+{
+    // k * n / nruns 를 넘치지 않게
+    return (size_t)k * (c->n / (size_t)c->nruns) + (size_t)k * (c->n % (size_t)c->nruns) / (size_t)c->nruns;
+}
+
+static void msort_runs(long start, long stop, void *arg)
+{
+    const msort_ctx *c = (const msort_ctx *)arg;
+    for (long k = start; k < stop; ++k)
+    {
+        size_t lo = run_start(c, k), hi = run_start(c, k + 1);
+        serial_msort(&c->e, AT(c->base, lo, c->e.size), AT(c->tmp, lo, c->e.size), hi - lo);
+    }
+}
+
+/* 조각 t = 짝 t / tp 의 출력 중 (t % tp) 번째 등분 */
+static void msort_merge(long start, long stop, void *arg)
+{
+    const msort_ctx *c = (const msort_ctx *)arg;
+    const size_t sz = c->e.size;
+    for (long t = start; t < stop; ++t)
+    {
+        long p = t / c->tp, s = t % c->tp;
+        size_t lo = run_start(c, 2 * p * c->width);
+        size_t mid = run_start(c, (2 * p + 1) * c->width);
+        size_t hi = run_start(c, (2 * p + 2) * c->width);
+        const unsigned char *a = AT(c->base, lo, sz), *b = AT(c->base, mid, sz);
+        size_t na = mid - lo, nb = hi - mid, len = hi - lo;
+        size_t k0 = len * (size_t)s / (size_t)c->tp, k1 = len * (size_t)(s + 1) / (size_t)c->tp;
+        size_t i0 = co_rank(&c->e, a, na, b, nb, k0), i1 = co_rank(&c->e, a, na, b, nb, k1);
+        merge_runs(&c->e, AT(a, i0, sz), i1 - i0, AT(b, k0 - i0, sz), (k1 - i1) - (k0 - i0),
+                   AT(c->tmp, lo + k0, sz));
+    }
+}
+
+static int msort(const runner *r, unsigned char *base, unsigned char *tmp, size_t n, const elem_ops *e)
+{
+    if (r->serial) { serial_msort(e, base, tmp, n); return 0; }
+
+    // 워커당 run 둘: 병합 단계마다 조각 수도 같다
+    long nruns = 1;
+    while (nruns < 2L * runner_workers(r) && (size_t)nruns * 2 * MSORT_INSERTION <= n) nruns *= 2;
+    msort_ctx c = { .e=*e, .base=base, .tmp=tmp, .n=n, .nruns=nruns };
+    int rc = runner_for(r, nruns, msort_runs, &c);
+    for (long w = 1; rc == 0 && w < nruns; w *= 2)
+    {
+        c.width = w;
+        c.tp = 2 * w;       // 짝 nruns / 2w 개 x 조각 2w 개 = nruns
+        rc = runner_for(r, nruns, msort_merge, &c);
+        unsigned char *t = c.base; c.base = c.tmp; c.tmp = t;
+    }
+    if (rc == 0 && c.base != base) rc = parallel_copy(r->pool, base, c.base, n * e->size, r->options);
+    return rc;
+}
+
+int parallel_sort(parallel_pool *pool, void *base, size_t n, size_t size,
+                  psort_cmp_fn cmp, void *userdata, void *scratch, int options)
+{
+    if (!size || !cmp || (n && !base)) return -1;
+    if (n < 2) return 0;
+    void *mem = scratch ? NULL : malloc(n * size);
+    if (!scratch && !mem) return -2;
+    runner r;
+    int rc = runner_init(&r, pool, n, options);
+    elem_ops e = { .size=size, .cmp=cmp, .userdata=userdata };
+    if (rc == 0) rc = msort(&r, (unsigned char *)base, (unsigned char *)(scratch ? scratch : mem), n, &e);
+    runner_fini(&r);
+    free(mem);
+    return rc;
+}
+
+/* ---- LSD radix ---- */
+typedef struct
+{
+    const void *src;
+    void *dst;
+    size_t n, block;
+    long nblocks;
+    unsigned shift;
+    uint64_t flip;      // 부호 있는 키: 최상위 비트를 뒤집으면 부호 없는 순서와 같다
+    long *counts;       // [자리 값][블록]: 히스토그램, scan 뒤에는 흩뿌릴 시작 자리
+} radix_ctx;
+
+#define RADIX_KERNELS(T)                                                                    \
+static void radix_hist_##T(long start, long stop, void *arg)                                \
+{                                                                                           \
+    const radix_ctx *c = (const radix_ctx *)arg;                                            \
+    const T *s = (const T *)c->src;                                                         \
+    for (long b = start; b < stop; ++b)                                                     \
+    {                                                                                       \
+        long h[RADIX_DIGITS] = {0};                                                         \
+        size_t lo = (size_t)b * c->block, hi = lo + c->block < c->n ? lo + c->block : c->n; \
+        for (size_t i = lo; i < hi; ++i) ++h[((s[i] ^ (T)c->flip) >> c->shift) & (RADIX_DIGITS - 1)]; \
+        for (int d = 0; d < RADIX_DIGITS; ++d) c->counts[(long)d * c->nblocks + b] = h[d]; \
+    }                                                                                       \
+}                                                                                           \
+                                                                                            \
+static void radix_scatter_##T(long start, long stop, void *arg)                             \
+{                                                                                           \
+    const radix_ctx *c = (const radix_ctx *)arg;                                            \
+    const T *s = (const T *)c->src;                                                         \
+    T *out = (T *)c->dst;                                                                   \
+    for (long b = start; b < stop; ++b)                                                     \
+    {                                                                                       \
+        long pos[RADIX_DIGITS];                                                             \
+        for (int d = 0; d < RADIX_DIGITS; ++d) pos[d] = c->counts[(long)d * c->nblocks + b]; \
+        size_t lo = (size_t)b * c->block, hi = lo + c->block < c->n ? lo + c->block : c->n; \
+        for (size_t i = lo; i < hi; ++i)                                                    \
+        {                                                                                   \
+            T k = s[i];                                                                     \
+            out[pos[((k ^ (T)c->flip) >> c->shift) & (RADIX_DIGITS - 1)]++] = k;            \
+        }                                                                                   \
+    }                                                                                       \
+}
+
+RADIX_KERNELS(uint32_t)
+RADIX_KERNELS(uint64_t)
+
+static int radix_sort(parallel_pool *pool, void *keys, size_t n, size_t width, uint64_t flip,
+                      void *scratch, int options)
+{
+    if (n && !keys) return -1;
+    if (n < 2) return 0;
+    void *mem = NULL;
+    if (!scratch)
+    {
+        if (posix_memalign(&mem, 64, parallel_sort_scratch_size(n, width)) != 0) return -2;
+        scratch = mem;
+    }
+    runner r;
+    int rc = runner_init(&r, pool, n, options);
+
+    radix_ctx c = { .n=n, .nblocks=radix_blocks(n), .flip=flip };
+    c.block = (n + (size_t)c.nblocks - 1) / (size_t)c.nblocks;
+    uintptr_t hist = ((uintptr_t)scratch + ((n * width + 63) & ~(size_t)63) + 63) & ~(uintptr_t)63;
+    c.counts = (long *)hist;
+    const long nc = (long)RADIX_DIGITS * c.nblocks;
+    pfor_range_fn hist_fn = width == 4 ? radix_hist_uint32_t : radix_hist_uint64_t;
+    pfor_range_fn scatter_fn = width == 4 ? radix_scatter_uint32_t : radix_scatter_uint64_t;
+
+    void *cur = keys, *other = scratch;
+    for (unsigned shift = 0; rc == 0 && shift < 8 * width; shift += RADIX_BITS)
+    {
+        c.src = cur; c.dst = other; c.shift = shift;
+        rc = runner_for(&r, c.nblocks, hist_fn, &c);
+        if (rc != 0) break;
+
+        // 첫 키의 자리 값이 n 개 전부면 이 자리에서는 순서가 그대로다
+        uint64_t k0 = width == 4 ? *(const uint32_t *)cur : *(const uint64_t *)cur;
+        long d0 = (long)(((k0 ^ flip) >> shift) & (RADIX_DIGITS - 1)), same = 0;
+        for (long b = 0; b < c.nblocks; ++b) same += c.counts[d0 * c.nblocks + b];
+        if ((size_t)same == n) continue;
+
+        // 자리 값 순, 그 안에서 블록 순: exclusive scan 이 곧 흩뿌릴 시작 자리.
+        // 많아야 256 x RADIX_MAX_BLOCKS 개라 직렬로: parallel_scan 은 부를 때마다 블록 합을 할당한다
+        for (long i = 0, run = 0; i < nc; ++i) { long x = c.counts[i]; c.counts[i] = run; run += x; }
+        rc = runner_for(&r, c.nblocks, scatter_fn, &c);
+        void *t = cur; cur = other; other = t;
+    }
+    if (rc == 0 && cur != keys)
+        rc = r.serial ? (memcpy(keys, cur, n * width), 0) : parallel_copy(r.pool, keys, cur, n * width, r.options);
+    runner_fini(&r);
+    free(mem);
+    return rc;
+}
+
+int parallel_sort_u32(parallel_pool *pool, uint32_t *keys, size_t n, void *scratch, int options)
+{
+    return radix_sort(pool, keys, n, sizeof(uint32_t), 0, scratch, options);
+}
+
+int parallel_sort_u64(parallel_pool *pool, uint64_t *keys, size_t n, void *scratch, int options)
+{
+    return radix_sort(pool, keys, n, sizeof(uint64_t), 0, scratch, options);
+}
+
+int parallel_sort_i32(parallel_pool *pool, int32_t *keys, size_t n, void *scratch, int options)
+{
+    return radix_sort(pool, keys, n, sizeof(int32_t), (uint64_t)1 << 31, scratch, options);
+}
+
+int parallel_sort_i64(parallel_pool *pool, int64_t *keys, size_t n, void *scratch, int options)
+{
+    return radix_sort(pool, keys, n, sizeof(int64_t), (uint64_t)1 << 63, scratch, options);
+}
@@ -0,0 +1,306 @@
+/* topology.c */
+#define _GNU_SOURCE
+#include "topology.h"
+#include "parallel.h"
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef PARALLEL_SYSFS_CPU
+#  define PARALLEL_SYSFS_CPU "/sys/devices/system/cpu"
+#endif
+#ifndef PARALLEL_PROC_SELF
+#  define PARALLEL_PROC_SELF "/proc/self"
+#endif
+
+static int read_int(const char *path, int fallback)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) return fallback;
+    int v;
+    if (fscanf(f, "%d", &v) != 1) v = fallback;
+    fclose(f);
+    return v;
+}
+
+static long read_long(const char *path, long fallback)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) return fallback;
+    long v;
+    if (fscanf(f, "%ld", &v) != 1) v = fallback;
+    fclose(f);
+    return v;
+}
+
+/* cpuN/nodeM 심볼릭 링크로 NUMA 노드를 찾는다 */
+static int cpu_node(int cpu)
+{
+    char path[128];
+    snprintf(path, sizeof(path), PARALLEL_SYSFS_CPU "/cpu%d", cpu);
+    DIR *d = opendir(path);
+    if (!d) return 0;
+    int node = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL)
+    {
+        if (strncmp(e->d_name, "node", 4) == 0 && e->d_name[4] >= '0' && e->d_name[4] <= '9')
+        {
+            node = atoi(e->d_name + 4);
+            break;
+        }
+    }
+    closedir(d);
+    return node;
+}
+
+static int cmp_physical(const void *a, const void *b)
+{
+    const topo_cpu *x = (const topo_cpu *)a, *y = (const topo_cpu *)b;
+    if (x->node    != y->node)    return x->node    < y->node    ? -1 : 1;
+    if (x->package != y->package) return x->package < y->package ? -1 : 1;
+    if (x->core    != y->core)    return x->core    < y->core    ? -1 : 1;
+    return x->cpu < y->cpu ? -1 : (x->cpu > y->cpu);
+}
+
+/* compact: 노드 → 코어 → SMT 형제 순으로 빽빽하게 */
+static int cmp_compact(const void *a, const void *b)
+{
+    const topo_cpu *x = (const topo_cpu *)a, *y = (const topo_cpu *)b;
+    if (x->node      != y->node)      return x->node      < y->node      ? -1 : 1;
+    if (x->core_rank != y->core_rank) return x->core_rank < y->core_rank ? -1 : 1;
+    if (x->smt       != y->smt)       return x->smt       < y->smt       ? -1 : 1;
+    return x->cpu < y->cpu ? -1 : (x->cpu > y->cpu);
+}
+
+/* scatter: 물리 코어를 노드마다 번갈아 먼저 채우고 SMT 형제는 마지막에 */
+static int cmp_scatter(const void *a, const void *b)
+{
+    const topo_cpu *x = (const topo_cpu *)a, *y = (const topo_cpu *)b;
+    if (x->smt       != y->smt)       return x->smt       < y->smt       ? -1 : 1;
+    if (x->core_rank != y->core_rank) return x->core_rank < y->core_rank ? -1 : 1;
+    if (x->node      != y->node)      return x->node      < y->node      ? -1 : 1;
+    return x->cpu < y->cpu ? -1 : (x->cpu > y->cpu);
+}
+
+int topo_discover(const cpu_set_t *allowed, topo_cpu **out)
+{
+    int n = CPU_COUNT(allowed);
+    *out = NULL;
+    if (n <= 0) return -1;
+    topo_cpu *cpus = (topo_cpu *)calloc((size_t)n, sizeof(*cpus));
+    if (!cpus) return -1;
+
+    int k = 0;
+    char path[160];
+    for (int cpu = 0; cpu < CPU_SETSIZE && k < n; ++cpu)
+    {
+        if (!CPU_ISSET(cpu, allowed)) continue;
+        topo_cpu *c = &cpus[k++];
+        c->cpu = cpu;
+        snprintf(path, sizeof(path), PARALLEL_SYSFS_CPU "/cpu%d/topology/physical_package_id", cpu);
+        c->package = read_int(path, 0);
+        snprintf(path, sizeof(path), PARALLEL_SYSFS_CPU "/cpu%d/topology/core_id", cpu);
+        c->core = read_int(path, cpu);
+        c->node = cpu_node(cpu);
+    }
+
+    // 물리 코어별로 정렬한 뒤 SMT 순번과 노드 내 코어 순번을 매긴다
+    qsort(cpus, (size_t)k, sizeof(*cpus), cmp_physical);
+    int rank = -1;
+    for (int i = 0; i < k; ++i)
+    {
+        const topo_cpu *p = i > 0 ? &cpus[i - 1] : NULL;
+        int same_core = p && p->node == cpus[i].node &&
+                        p->package == cpus[i].package && p->core == cpus[i].core;
+        if (!p || p->node != cpus[i].node) rank = -1;
+        cpus[i].smt = same_core ? p->smt + 1 : 0;
+        if (!same_core) ++rank;
+        cpus[i].core_rank = rank;
+    }
+
+    *out = cpus;
+    return k;
+}
+
+int topo_cpu_order(int placement, int **out)
+{
+    *out = NULL;
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) != 0) return 0;
+
+    int available = CPU_COUNT(&mask);
+    if (available <= 0) return 0;
+    int *ids = (int *)malloc((size_t)available * sizeof(*ids));
+    if (!ids) return 0;
+
+    placement &= PARALLEL_OPT_PLACE_MASK;
+    topo_cpu *cpus = NULL;
+    int n = placement == PARALLEL_OPT_PLACE_LINEAR ? -1 : topo_discover(&mask, &cpus);
+    if (n <= 0)
+    {
+        // raw CPU 번호 순
+        int count = 0;
+        for (int cpu = 0; cpu < CPU_SETSIZE && count < available; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &mask)) ids[count++] = cpu;
+        }
+        *out = ids;
+        return count;
+    }
+
+    switch (placement)
+    {
+        case PARALLEL_OPT_PLACE_SCATTER:
+            qsort(cpus, (size_t)n, sizeof(*cpus), cmp_scatter);
+            break;
+        default:
+            qsort(cpus, (size_t)n, sizeof(*cpus), cmp_compact);
+            break;
+    }
+
+    int count = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        if (placement == PARALLEL_OPT_PLACE_PHYSICAL && cpus[i].smt != 0) continue;
+        ids[count++] = cpus[i].cpu;
+    }
+    free(cpus);
+    *out = ids;
+    return count;
+}
+
+int topo_cpu_count(void)
+{
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    int n = sched_getaffinity(0, sizeof(mask), &mask) == 0 ? CPU_COUNT(&mask) : 0;
+    if (n <= 0) n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? n : 1;
+}
+
+/* 쉼표로 나뉜 list 에 word 가 있나 */
+static int has_word(const char *list, const char *word)
+{
+    size_t len = strlen(word);
+    for (const char *p = list; *p; )
+    {
+        const char *e = strchr(p, ',');
+        size_t n = e ? (size_t)(e - p) : strlen(p);
+        if (n == len && memcmp(p, word, len) == 0) return 1;
+        if (!e) break;
+        p = e + 1;
+    }
+    return 0;
+}
+
+/* cgroup 디렉터리 하나의 CPU 한도 (quota / period 올림), 없으면 0 */
+static int cgroup_dir_limit(const char *dir, int v2)
+{
+    char path[PATH_MAX + 32];
+    long quota = -1, period = 0;
+    if (v2)
+    {
+        // "max 100000" 또는 "400000 100000"
+        snprintf(path, sizeof(path), "%s/cpu.max", dir);
+        FILE *f = fopen(path, "r");
+        if (!f) return 0;
+        char q[32];
+        if (fscanf(f, "%31s %ld", q, &period) == 2 && strcmp(q, "max") != 0)
+            quota = strtol(q, NULL, 10);
+        fclose(f);
+    }
+    else
+    {
+        snprintf(path, sizeof(path), "%s/cpu.cfs_quota_us", dir);
+        quota = read_long(path, -1);
+        snprintf(path, sizeof(path), "%s/cpu.cfs_period_us", dir);
+        period = read_long(path, 0);
+    }
+    if (quota <= 0 || period <= 0) return 0;
+    long n = (quota + period - 1) / period;
+    return n > INT_MAX ? INT_MAX : (int)n;
+}
+
+/* v2 통합 계층 또는 cpu 컨트롤러가 붙은 v1 계층에서 이 프로세스의 cgroup 과 그 조상들 중
+ * 가장 작은 한도. 계층을 못 찾거나 한도가 없으면 0 */
+static int cgroup_limit(int v2)
+{
+    char line[PATH_MAX + 256], cg[PATH_MAX] = "";
+    int found = 0;
+    FILE *f = fopen(PARALLEL_PROC_SELF "/cgroup", "r");
+    if (!f) return 0;
+    // "0::/path" (v2), "4:cpu,cpuacct:/path" (v1)
+    while (!found && fgets(line, sizeof(line), f))
+    {
+        char *c1 = strchr(line, ':');
+        char *c2 = c1 ? strchr(c1 + 1, ':') : NULL;
+        if (!c2) continue;
+        *c2 = '\0';
+        found = v2 ? strcmp(line, "0:") == 0 && c2 == c1 + 1 : has_word(c1 + 1, "cpu");
+        if (found)
+        {
+            snprintf(cg, sizeof(cg), "%s", c2 + 1);
+            cg[strcspn(cg, "\n")] = '\0';
+        }
+    }
+    fclose(f);
+    if (!found) return 0;
+
+    // mountinfo: "id parent maj:min root mountpoint opts ... - fstype source superopts"
+    char root[PATH_MAX], mnt[PATH_MAX], dir[PATH_MAX];
+    found = 0;
+    f = fopen(PARALLEL_PROC_SELF "/mountinfo", "r");
+    if (!f) return 0;
+    while (!found && fgets(line, sizeof(line), f))
+    {
+        char *sep = strstr(line, " - ");
+        char fstype[32], super[256];
+        if (!sep || sscanf(line, "%*s %*s %*s %4095s %4095s", root, mnt) != 2) continue;
+        if (sscanf(sep + 3, "%31s %*s %255s", fstype, super) != 2) continue;
+        found = v2 ? strcmp(fstype, "cgroup2") == 0
+                   : strcmp(fstype, "cgroup") == 0 && has_word(super, "cpu");
+    }
+    fclose(f);
+    if (!found) return 0;
+
+    // 마운트가 계층의 root 아래를 보여주면 그만큼 떼어 낸다 (네임스페이스 밖 경로면 마운트 자체)
+    const char *rel = cg;
+    size_t rlen = strlen(root);
+    if (strcmp(root, "/") != 0)
+        rel = strncmp(cg, root, rlen) == 0 && (cg[rlen] == '/' || cg[rlen] == '\0') ? cg + rlen : "";
+    if (snprintf(dir, sizeof(dir), "%s%s", mnt, rel) >= (int)sizeof(dir)) return 0;
+
+    // 조상의 한도도 걸린다: 마운트 지점까지 올라가며 가장 작은 값
+    size_t mlen = strlen(mnt);
+    int best = 0;
+    for (;;)
+    {
+        int n = cgroup_dir_limit(dir, v2);
+        if (n > 0 && (best == 0 || n < best)) best = n;
+        char *slash = strrchr(dir, '/');
+        if (!slash || (size_t)(slash - dir) < mlen) break;
+        *slash = '\0';
+    }
+    return best;
+}
+
+static int quota_cpus;
+static pthread_once_t quota_once = PTHREAD_ONCE_INIT;
+
+static void quota_init(void)
+{
+    int v2 = cgroup_limit(1), v1 = cgroup_limit(0);
+    quota_cpus = v2 > 0 && (v1 <= 0 || v2 < v1) ? v2 : v1;
+}
+
+int topo_cpu_quota(void)
+{
+    pthread_once(&quota_once, quota_init);
+    return quota_cpus;
+}
@@ -0,0 +1,27 @@
+/* topology.h — 내부용: CPU 토폴로지 탐색과 워커 배치 순서 */
+#pragma once
+#include <sched.h>     // cpu_set_t: _GNU_SOURCE 가 먼저 정의돼 있어야 함
+
+typedef struct
+{
+    int cpu;
+    int node;           // NUMA 노드 (없으면 0)
+    int package;        // 소켓
+    int core;           // 소켓 내 core_id
+    int smt;            // 같은 물리 코어 안에서의 순번 (0 = 첫 하드웨어 스레드)
+    int core_rank;      // 노드 안에서 물리 코어 순번
+} topo_cpu;
+
+/* allowed 의 CPU들을 sysfs 로 분류한다. 반환값은 개수, 실패 시 -1 (*out 은 free) */
+int topo_discover(const cpu_set_t *allowed, topo_cpu **out);
+
+/* 현재 affinity 안의 CPU를 placement(PARALLEL_OPT_PLACE_*) 순서로 *out 에 채운다.
+ * 반환값은 개수, 실패 시 0 */
+int topo_cpu_order(int placement, int **out);
+
+/* 현재 affinity 안의 CPU 수 (sched_getaffinity 실패 시 온라인 CPU 수), 최소 1 */
+int topo_cpu_count(void);
+
+/* cgroup v2 cpu.max / v1 cpu.cfs_quota_us 한도를 CPU 수로 올림한 값 (조상 포함 최소).
+ * 한도가 없으면 0. 처음 부를 때 한 번 읽는다 */
+int topo_cpu_quota(void);
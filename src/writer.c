@@ -0,0 +1,400 @@
+/* writer.c */
+#define _GNU_SOURCE
+#include "writer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#if defined(__NR_io_uring_setup) && defined(__has_include)
+#  if __has_include(<linux/io_uring.h>)
+#    include <linux/io_uring.h>
+#    define WRITER_HAVE_URING 1
+#  endif
+#endif
+
+#define WR_QD       8                   // 동시에 나가 있는 요청 수
+#define WR_IOV      64                  // 요청 하나에 묶는 iovec 수
+#define WR_BATCH    ((size_t)4 << 20)   // 요청 하나의 목표 크기 (O_DIRECT 면 bounce 버퍼 크기)
+#define WR_ALIGN    4096                // O_DIRECT 오프셋/길이/주소 정렬
+
+typedef struct
+{
+    struct iovec iov[WR_IOV];
+    int niov;
+    size_t len;
+    off_t off;
+    int busy;                   // io_uring 에 제출됨
+    unsigned char *bounce;      // O_DIRECT: WR_BATCH 크기, 페이지 정렬
+} wr_req;
+
+#ifdef WRITER_HAVE_URING
+typedef struct
+{
+    int fd;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr, *cq_ptr;
+    size_t sq_sz, cq_sz, sqes_sz;
+} uring;
+#endif
+
+struct writer
+{
+    int fd, own_fd;
+    int direct, seekable, uring, placed;
+    off_t off;                  // 다음 요청의 파일 오프셋
+    size_t total;               // 받은 바이트 (O_DIRECT 면 ftruncate 길이), placed 면 쓴 끝 (atomic max)
+    wr_req req[WR_QD];
+    int nreq, cur;              // 요청 슬롯 수, 채우는 중인 슬롯
+    int err;                    // 첫 errno
+    unsigned char *bounce_mem;
+    size_t bounce_sz;
+    char name[32];
+#ifdef WRITER_HAVE_URING
+    uring ring;
+#endif
+};
+
+/* iov 를 끝까지 쓴다 (부분 쓰기면 이어서). 성공 0, 실패 errno */
+static int write_all(int fd, int seekable, struct iovec *iov, int niov, off_t off)
+{
+    while (niov > 0)
+    {
+        int n = niov > IOV_MAX ? IOV_MAX : niov;
+        ssize_t r = seekable ? pwritev(fd, iov, n, off) : writev(fd, iov, n);
+        if (r < 0)
+        {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+        if (r == 0) return EIO;
+        off += r;
+        while (niov > 0 && (size_t)r >= iov->iov_len) { r -= (ssize_t)iov->iov_len; ++iov; --niov; }
+        if (niov > 0) { iov->iov_base = (char *)iov->iov_base + r; iov->iov_len -= (size_t)r; }
+    }
+    return 0;
+}
+
+static void set_err(writer *w, int e)
+{
+    if (!w->err) w->err = e;
+}
+
+static void req_reset(wr_req *r)
+{
+    r->niov = 0;
+    r->len = 0;
+    r->busy = 0;
+}
+
+/* ---- io_uring (liburing 없이 시스템 콜 직접) ---- */
+#ifdef WRITER_HAVE_URING
+static int uring_init(uring *u, unsigned entries)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(u, 0, sizeof(*u));
+    u->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (u->fd < 0) return -1;      // 커널이 없거나 seccomp / io_uring_disabled
+
+    u->sq_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->cq_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    int single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) u->sq_sz = u->cq_sz = u->sq_sz > u->cq_sz ? u->sq_sz : u->cq_sz;
+    u->sq_ptr = mmap(NULL, u->sq_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+    if (u->sq_ptr == MAP_FAILED) { close(u->fd); return -1; }
+    u->cq_ptr = single ? u->sq_ptr
+                       : mmap(NULL, u->cq_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+    u->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = u->cq_ptr == MAP_FAILED ? MAP_FAILED
+            : (struct io_uring_sqe *)mmap(NULL, u->sqes_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                          u->fd, IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED)
+    {
+        if (u->cq_ptr != MAP_FAILED && !single) munmap(u->cq_ptr, u->cq_sz);
+        munmap(u->sq_ptr, u->sq_sz);
+        close(u->fd);
+        return -1;
+    }
+
+    unsigned char *sq = (unsigned char *)u->sq_ptr, *cq = (unsigned char *)u->cq_ptr;
+    u->sq_tail  = (unsigned *)(sq + p.sq_off.tail);
+    u->sq_mask  = (unsigned *)(sq + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)(sq + p.sq_off.array);
+    u->cq_head  = (unsigned *)(cq + p.cq_off.head);
+    u->cq_tail  = (unsigned *)(cq + p.cq_off.tail);
+    u->cq_mask  = (unsigned *)(cq + p.cq_off.ring_mask);
+    u->cqes     = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
+}
+
+static void uring_fini(uring *u)
+{
+    munmap(u->sqes, u->sqes_sz);
+    if (u->cq_ptr != u->sq_ptr) munmap(u->cq_ptr, u->cq_sz);
+    munmap(u->sq_ptr, u->sq_sz);
+    close(u->fd);
+}
+
+static int uring_enter(uring *u, unsigned submit, unsigned wait)
+{
+    for (;;)
+    {
+        long r = syscall(__NR_io_uring_enter, u->fd, submit, wait, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (r >= 0 || errno != EINTR) return r < 0 ? errno : 0;
+    }
+}
+
+/* 나가 있는 요청은 WR_QD 이하라 SQ 가 넘치지 않는다 */
+static void uring_submit(writer *w, int slot)
+{
+    uring *u = &w->ring;
+    wr_req *r = &w->req[slot];
+    unsigned tail = *u->sq_tail, idx = tail & *u->sq_mask;
+    struct io_uring_sqe *sqe = &u->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = IORING_OP_WRITEV;
+    sqe->fd        = w->fd;
+    sqe->addr      = (uint64_t)(uintptr_t)r->iov;
+    sqe->len       = (unsigned)r->niov;
+    sqe->off       = (uint64_t)r->off;
+    sqe->user_data = (uint64_t)slot;
+    u->sq_array[idx] = idx;
+    __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    r->busy = 1;
+    int e = uring_enter(u, 1, 0);
+    if (e) set_err(w, e);
+}
+
+/* 완료를 거둔다. wait 이면 하나 이상 끝날 때까지 기다린다. 거둔 개수 */
+static int uring_reap(writer *w, int wait)
+{
+    uring *u = &w->ring;
+    int got = 0;
+    for (;;)
+    {
+        unsigned head = *u->cq_head, tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+        if (head != tail)
+        {
+            struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+            wr_req *r = &w->req[cqe->user_data];
+            if (cqe->res < 0) set_err(w, -cqe->res);
+            else if ((size_t)cqe->res < r->len)
+            {
+                // 짧은 쓰기: 나머지는 여기서 동기로
+                size_t done = (size_t)cqe->res;
+                int i = 0;
+                while (done >= r->iov[i].iov_len) { done -= r->iov[i].iov_len; ++i; }
+                r->iov[i].iov_base = (char *)r->iov[i].iov_base + done;
+                r->iov[i].iov_len -= done;
+                int e = write_all(w->fd, 1, &r->iov[i], r->niov - i, r->off + cqe->res);
+                if (e) set_err(w, e);
+            }
+            req_reset(r);
+            __atomic_store_n(u->cq_head, head + 1, __ATOMIC_RELEASE);
+            ++got;
+            continue;
+        }
+        if (!wait || got) return got;
+        int e = uring_enter(u, 0, 1);
+        if (e) { set_err(w, e); return got; }
+    }
+}
+#endif
+
+/* cur 슬롯을 내보내고 다음에 채울 빈 슬롯을 고른다 */
+static void submit_cur(writer *w)
+{
+    wr_req *r = &w->req[w->cur];
+    if (r->len == 0) return;
+    r->off = w->off;
+    w->off += (off_t)r->len;
+    if (w->direct) { r->iov[0].iov_base = r->bounce; r->iov[0].iov_len = r->len; r->niov = 1; }
+#ifdef WRITER_HAVE_URING
+    if (w->uring)
+    {
+        uring_submit(w, w->cur);
+        for (;;)
+        {
+            for (int i = 0; i < w->nreq; ++i)
+                if (!w->req[i].busy) { w->cur = i; return; }
+            uring_reap(w, 1);
+        }
+    }
+#endif
+    int e = write_all(w->fd, w->seekable, r->iov, r->niov, r->off);
+    if (e) set_err(w, e);
+    req_reset(r);
+}
+
+writer *writer_open(const char *path, int flags)
+{
+    writer *w = (writer *)calloc(1, sizeof(writer));
+    if (!w) return NULL;
+    int to_stdout = !strcmp(path, "-");
+    if ((flags & WRITER_PLACED) && (to_stdout || (flags & WRITER_DIRECT))) { free(w); return NULL; }
+    if (to_stdout)
+    {
+        w->fd = STDOUT_FILENO;
+        flags &= ~WRITER_DIRECT;
+    }
+    else
+    {
+        int oflags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+        w->fd = open(path, oflags | ((flags & WRITER_DIRECT) ? O_DIRECT : 0), 0644);
+        if (w->fd < 0 && (flags & WRITER_DIRECT) && errno == EINVAL)
+        {
+            fprintf(stderr, "writer: O_DIRECT not supported for %s, using buffered writes\n", path);
+            flags &= ~WRITER_DIRECT;
+            w->fd = open(path, oflags, 0644);
+        }
+        if (w->fd < 0) { perror("open"); free(w); return NULL; }
+        w->own_fd = 1;
+    }
+    w->seekable = lseek(w->fd, 0, SEEK_CUR) >= 0;
+    if (!w->seekable) flags &= ~WRITER_DIRECT;
+    w->direct = (flags & WRITER_DIRECT) != 0;
+    w->placed = (flags & WRITER_PLACED) != 0;
+    w->nreq = 1;
+    if (w->placed)
+    {
+        snprintf(w->name, sizeof(w->name), "pwrite at offset");
+        return w;
+    }
+
+#ifdef WRITER_HAVE_URING
+    if (w->seekable && !(flags & WRITER_NO_URING) && uring_init(&w->ring, WR_QD) == 0)
+    {
+        w->uring = 1;
+        w->nreq = WR_QD;
+    }
+#endif
+    if (w->direct)
+    {
+        w->bounce_sz = (size_t)w->nreq * WR_BATCH;
+        void *p = mmap(NULL, w->bounce_sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+        {
+            perror("mmap");
+            writer_close(w);
+            return NULL;
+        }
+        w->bounce_mem = (unsigned char *)p;
+        for (int i = 0; i < w->nreq; ++i) w->req[i].bounce = w->bounce_mem + (size_t)i * WR_BATCH;
+    }
+    snprintf(w->name, sizeof(w->name), "%s%s", w->uring ? "io_uring" : w->seekable ? "pwritev" : "writev",
+             w->direct ? " O_DIRECT" : "");
+    return w;
+}
+
+int writer_append(writer *w, const void *buf, size_t len)
+{
+    if (w->placed) return -1;
+    const unsigned char *p = (const unsigned char *)buf;
+    w->total += len;
+    while (len > 0 && !w->err)
+    {
+        wr_req *r = &w->req[w->cur];
+        if (w->direct)
+        {
+            // bounce 버퍼가 꽉 찰 때마다 정렬된 한 덩어리로 내보낸다
+            size_t n = WR_BATCH - r->len < len ? WR_BATCH - r->len : len;
+            memcpy(r->bounce + r->len, p, n);
+            r->len += n; p += n; len -= n;
+            if (r->len == WR_BATCH) submit_cur(w);
+        }
+        else
+        {
+            if (r->niov == WR_IOV) { submit_cur(w); continue; }
+            r->iov[r->niov].iov_base = (void *)p;
+            r->iov[r->niov].iov_len = len;
+            r->niov++;
+            r->len += len;
+            len = 0;
+            if (r->len >= WR_BATCH) submit_cur(w);
+        }
+    }
+    return w->err ? -1 : 0;
+}
+
+int writer_write_at(writer *w, struct iovec *iov, int niov, off_t off)
+{
+    if (!w->placed) return -1;
+    size_t len = 0;
+    for (int i = 0; i < niov; ++i) len += iov[i].iov_len;
+    int e = write_all(w->fd, 1, iov, niov, off);
+    if (e)
+    {
+        int zero = 0;
+        __atomic_compare_exchange_n(&w->err, &zero, e, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        return -1;
+    }
+    size_t end = (size_t)off + len, cur = __atomic_load_n(&w->total, __ATOMIC_RELAXED);
+    while (end > cur && !__atomic_compare_exchange_n(&w->total, &cur, end, 0,
+                                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+    return __atomic_load_n(&w->err, __ATOMIC_RELAXED) ? -1 : 0;
+}
+
+/* O_DIRECT 의 덜 찬 bounce 는 close 때 패딩해서 쓴다 (그 데이터는 이미 복사본) */
+int writer_drain(writer *w)
+{
+    if (!w->direct) submit_cur(w);
+#ifdef WRITER_HAVE_URING
+    if (w->uring)
+    {
+        for (;;)
+        {
+            int busy = 0;
+            for (int i = 0; i < w->nreq; ++i) busy |= w->req[i].busy;
+            if (!busy || w->err) break;
+            uring_reap(w, 1);
+        }
+    }
+#endif
+    return w->err ? -1 : 0;
+}
+
+int writer_close(writer *w)
+{
+    if (!w) return -1;
+    writer_drain(w);
+    if (w->direct && !w->err)
+    {
+        wr_req *r = &w->req[w->cur];
+        if (r->len % WR_ALIGN)
+        {
+            size_t pad = WR_ALIGN - r->len % WR_ALIGN;
+            memset(r->bounce + r->len, 0, pad);
+            r->len += pad;
+        }
+        submit_cur(w);
+        writer_drain(w);
+        if (!w->err && ftruncate(w->fd, (off_t)w->total) != 0) set_err(w, errno);
+    }
+    // 오프셋 쓰기는 끝 블록이 먼저 끝나면 구멍이 잠깐 생긴다: 길이를 쓴 끝으로 못박는다
+    if (w->placed && !w->err && ftruncate(w->fd, (off_t)w->total) != 0) set_err(w, errno);
+#ifdef WRITER_HAVE_URING
+    if (w->uring) uring_fini(&w->ring);
+#endif
+    if (w->bounce_mem) munmap(w->bounce_mem, w->bounce_sz);
+    if (w->own_fd && close(w->fd) != 0) set_err(w, errno);
+    int err = w->err;
+    if (err) fprintf(stderr, "writer (%s): %s\n", w->name, strerror(err));
+    free(w);
+    return err ? -1 : 0;
+}
+
+const char *writer_backend(const writer *w)
+{
+    return w->name;
+}
@@ -0,0 +1,37 @@
+/* writer.h — 출력 writer: 순차 (io_uring 비동기 쓰기, 없으면 pwritev 묶음) 또는 오프셋 지정 pwrite */
+#pragma once
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+enum writer_flags
+{
+    WRITER_DIRECT   = 1 << 0,   // O_DIRECT (지원 안 하는 파일시스템이면 일반 쓰기로)
+    WRITER_NO_URING = 1 << 1,   // io_uring 을 쓰지 않고 pwritev 로만
+    WRITER_PLACED   = 1 << 2,   // writer_write_at 만 (일반 파일, O_DIRECT 아닐 때). append 불가
+};
+
+typedef struct writer writer;
+
+/* path 를 새로 만들어 연다. "-" 면 stdout (O_DIRECT / 오프셋 쓰기 없이 writev).
+ * WRITER_PLACED 는 stdout 이나 O_DIRECT 와 같이 쓸 수 없다 (NULL).
+ * 실패 시 NULL */
+writer *writer_open(const char *path, int flags);
+
+/* 파일 끝에 len 바이트를 이어 쓴다. 쓰기는 뒤에서 진행되므로
+ * buf 는 writer_drain / writer_close 까지 살아 있어야 한다 (O_DIRECT 는 바로 복사).
+ * 성공 0, 앞선 쓰기가 실패했으면 -1 */
+int writer_append(writer *w, const void *buf, size_t len);
+
+/* 넘긴 데이터를 모두 쓰고 돌아온다. 이후 buf 들은 재사용해도 된다. 성공 0 */
+int writer_drain(writer *w);
+
+/* WRITER_PLACED: [off, off + iov 합) 에 바로 쓴다. 여러 스레드가 겹치지 않는 범위를
+ * 동시에 불러도 된다. 돌아오면 iov 는 재사용 가능 (내용은 바뀔 수 있다). 성공 0 */
+int writer_write_at(writer *w, struct iovec *iov, int niov, off_t off);
+
+/* drain, O_DIRECT 꼬리 정리 / WRITER_PLACED 길이 확정 (ftruncate), close 후 해제. 성공 0 */
+int writer_close(writer *w);
+
+/* "io_uring", "pwritev", "writev" (+ " O_DIRECT"), WRITER_PLACED 면 "pwrite at offset" */
+const char *writer_backend(const writer *w);
@@ -0,0 +1,29 @@
+/* check.h — 테스트 공용: 실패하면 위치를 찍고 바로 끝낸다 */
+#pragma once
+#include "parallel.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(x) do {                                                           \
+        if (!(x)) {                                                             \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); \
+            exit(1);                                                            \
+        }                                                                       \
+    } while (0)
+
+/* 재현 가능한 입력용 xorshift64* */
+static inline uint64_t test_rand(uint64_t *s)
+{
+    uint64_t x = *s;
+    x ^= x >> 12; x ^= x << 25; x ^= x >> 27;
+    *s = x;
+    return x * 2685821657736338717ULL;
+}
+
+static const int test_scheds[] =
+{
+    PARALLEL_OPT_SCHED_SHARED, PARALLEL_OPT_SCHED_STEAL, PARALLEL_OPT_SCHED_GUIDED,
+    PARALLEL_OPT_SCHED_ADAPTIVE, PARALLEL_OPT_SCHED_STATIC,
+};
+#define TEST_NSCHEDS ((int)(sizeof(test_scheds) / sizeof(test_scheds[0])))
@@ -0,0 +1,79 @@
+#!/bin/sh
+# pbz_test.sh — 코덱마다 압축 / 풀기 왕복, 인덱스 + -x 구간 추출
+# 사용: tests/pbz_test.sh [./pbz]
+set -u
+PBZ=${1:-./pbz}
+case $PBZ in /*) ;; *) PBZ=$(pwd)/$PBZ ;; esac
+T=$(mktemp -d) || exit 1
+trap 'rm -rf "$T"' EXIT
+fail=0
+
+die() { echo "pbz_test: $*" >&2; fail=1; }
+same() { cmp -s "$1" "$2" || die "$3: $1 != $2"; }
+
+# 입력: 빈 것, 1 바이트, 블록 여러 개 (잘 줄어드는 부분 + 난수)
+: > "$T/empty"
+printf x > "$T/one"
+{ seq 1 200000; head -c 300000 /dev/urandom; seq 7 3 400000; } > "$T/multi"
+
+codecs=$("$PBZ" -h 2>&1 | sed -n 's/^ *-C, --codec NAME *\(.*\) (default.*/\1/p')
+[ -n "$codecs" ] || { echo "pbz_test: no codecs in $PBZ -h" >&2; exit 1; }
+
+for c in $codecs; do
+    case $c in bzip2) sfx=.bz2 ;; gzip) sfx=.gz ;; zstd) sfx=.zst ;; lz4) sfx=.lz4 ;; *) sfx=.$c ;; esac
+    for f in empty one multi; do
+        in=$T/$f
+        # 파일 경로, -S, stdin, --direct 각각 압축해서 -d / -c / -t 로 되돌린다
+        "$PBZ" -q -k -f -C "$c" -b 100k -T 3 "$in" || die "$c $f: compress"
+        "$PBZ" -q -d -c "$in$sfx" > "$T/out" || die "$c $f: decompress -c"
+        same "$in" "$T/out" "$c $f file"
+        "$PBZ" -q -t "$in$sfx" || die "$c $f: -t"
+        "$PBZ" -q -d < "$in$sfx" > "$T/out" || die "$c $f: decompress stdin"
+        same "$in" "$T/out" "$c $f stdin"
+
+        "$PBZ" -q -k -f -S -C "$c" -b 64k -o "$T/s$sfx" "$in" || die "$c $f: -S"
+        "$PBZ" -q -d -k -f -o "$T/out" "$T/s$sfx" || die "$c $f: decompress -o"
+        same "$in" "$T/out" "$c $f -S"
+
+        "$PBZ" -q -C "$c" -b 128k < "$in" > "$T/p$sfx" || die "$c $f: compress stdin"
+        "$PBZ" -q -d -c "$T/p$sfx" > "$T/out" || die "$c $f: decompress pipe"
+        same "$in" "$T/out" "$c $f pipe"
+
+        "$PBZ" -q -k -f --direct -C "$c" -o "$T/o$sfx" "$in" || die "$c $f: --direct"
+        "$PBZ" -q -d -c "$T/o$sfx" > "$T/out" || die "$c $f: decompress --direct"
+        same "$in" "$T/out" "$c $f --direct"
+
+        # 표준 도구로도 풀린다
+        case $c in
+        bzip2|gzip)
+            if command -v "$c" >/dev/null 2>&1; then
+                "$c" -dc < "$in$sfx" > "$T/out" || die "$c $f: external $c -d"
+                same "$in" "$T/out" "$c $f external"
+            fi ;;
+        esac
+    done
+
+    # 인덱스 + -x: 블록 경계 앞뒤, 끝, 0 길이, 끝을 넘는 구간
+    "$PBZ" -q -k -f -i -C "$c" -b 100k -o "$T/i$sfx" "$T/multi" || die "$c: -i"
+    [ -s "$T/i$sfx.idx" ] || die "$c: no index"
+    total=$(wc -c < "$T/multi")
+    for r in 0:1 0:100 102399:2 102400:102400 250000:500000 $((total - 5)):5 $total:0 0:$total; do
+        o=${r%%:*}; l=${r#*:}
+        "$PBZ" -q -x "$r" "$T/i$sfx" > "$T/out" || die "$c: -x $r"
+        tail -c +$((o + 1)) "$T/multi" | head -c "$l" > "$T/want"
+        same "$T/want" "$T/out" "$c -x $r"
+    done
+    "$PBZ" -q -x $((total + 1)):1 "$T/i$sfx" > "$T/out" 2>/dev/null && die "$c: -x past the end accepted"
+    "$PBZ" -q -f -x 10:20 -o "$T/x" "$T/i$sfx" || die "$c: -x -o"
+    tail -c +11 "$T/multi" | head -c 20 > "$T/want"
+    same "$T/want" "$T/x" "$c -x -o"
+done
+
+# 깨진 입력은 실패해야 한다
+: > "$T/zero.bz2"
+"$PBZ" -q -t "$T/zero.bz2" 2>/dev/null && die "empty archive accepted"
+head -c 1000 "$T/multi.bz2" > "$T/cut.bz2"
+"$PBZ" -q -t "$T/cut.bz2" 2>/dev/null && die "truncated archive accepted"
+
+[ $fail = 0 ] && echo "pbz_test ($codecs): ok"
+exit $fail
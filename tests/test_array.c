@@ -0,0 +1,179 @@
+/* test_array.c — parallel_array 커널을 어긋난 머리 / 꼬리에서 스칼라 결과와 비교.
+ * ISA 는 PARALLEL_ISA 로 고른다 (make test 가 단계마다 다시 돌린다) */
+#include "check.h"
+#include "parallel_array.h"
+#include <math.h>
+#include <string.h>
+
+static const size_t sizes[] = { 0, 1, 3, 15, 63, 64, 65, 1000, 16411, 100003 };
+#define NSIZES ((int)(sizeof(sizes) / sizeof(sizes[0])))
+#define GUARD 64
+#define POISON 0xa5
+
+/* 앞뒤에 GUARD 바이트를 둔 버퍼. 돌려주는 포인터는 64B 경계에서 off 바이트 어긋난다 */
+static unsigned char *guarded(unsigned char **raw, size_t bytes, size_t off)
+{
+    CHECK(posix_memalign((void **)raw, 64, bytes + 2 * GUARD + 64) == 0);
+    memset(*raw, POISON, bytes + 2 * GUARD + 64);
+    return *raw + GUARD + off;
+}
+
+static void check_guard(const unsigned char *p, size_t bytes)
+{
+    for (size_t i = 1; i <= GUARD; ++i) CHECK(p[-(long)i] == POISON);
+    for (size_t i = 0; i < GUARD; ++i) CHECK(p[bytes + i] == POISON);
+}
+
+static void sq_f32(float *dst, const float *src, size_t n, void *userdata)
+{
+    const float c = *(const float *)userdata;
+    for (size_t i = 0; i < n; ++i) dst[i] = src[i] * src[i] + c;
+}
+
+static void sq_f64(double *dst, const double *src, size_t n, void *userdata)
+{
+    const double c = *(const double *)userdata;
+    for (size_t i = 0; i < n; ++i) dst[i] = src[i] * src[i] + c;
+}
+
+static void xor_u8(unsigned char *dst, const unsigned char *src, size_t n, void *userdata)
+{
+    const unsigned char c = *(const unsigned char *)userdata;
+    for (size_t i = 0; i < n; ++i) dst[i] = (unsigned char)(src[i] ^ c);
+}
+
+/* FMA 와 mul+add 의 차이 (한 번 반올림) 만 허용 */
+static int near_f(double got, double want, double a, double x, double eps)
+{
+    return fabs(got - want) <= eps * (fabs(a * x) + fabs(want)) + 1e-300;
+}
+
+static void check_float(parallel_pool *pool, size_t n, int in_place, int options)
+{
+    uint64_t seed = 5 + n;
+    unsigned char *rs, *rd, *rs64, *rd64;
+    const size_t off = (n % 3) * 4 + 4;    // 4B 원소지만 64B 에는 안 맞는 자리
+    float *src = (float *)guarded(&rs, n * sizeof(float), off);
+    float *dst = in_place ? src : (float *)guarded(&rd, n * sizeof(float), off + 8);
+    double *s64 = (double *)guarded(&rs64, n * sizeof(double), 8 * (n % 7 + 1));
+    double *d64 = in_place ? s64 : (double *)guarded(&rd64, n * sizeof(double), 8 * (n % 5));
+    float *ref = (float *)malloc(n * sizeof(float) + 1);
+    double *ref64 = (double *)malloc(n * sizeof(double) + 1);
+    CHECK(ref && ref64);
+    for (size_t i = 0; i < n; ++i)
+    {
+        src[i] = (float)((double)(test_rand(&seed) >> 40) / 1e4 - 800);
+        s64[i] = (double)(test_rand(&seed) >> 11) / 1e9 - 4e6;
+    }
+
+    const float cf = 0.25f;
+    const double cd = -3.5;
+    for (size_t i = 0; i < n; ++i) { ref[i] = src[i] * src[i] + cf; ref64[i] = s64[i] * s64[i] + cd; }
+    CHECK(parallel_transform_f32(pool, dst, src, n, sq_f32, (void *)&cf, options) == 0);
+    CHECK(parallel_transform_f64(pool, d64, s64, n, sq_f64, (void *)&cd, options) == 0);
+    for (size_t i = 0; i < n; ++i) { CHECK(dst[i] == ref[i]); CHECK(d64[i] == ref64[i]); }
+    check_guard((unsigned char *)dst, n * sizeof(float));
+    check_guard((unsigned char *)d64, n * sizeof(double));
+
+    // affine 은 지금 dst 를 입력으로 (제자리면 src 와 같다)
+    const float a = 1.75f, b = -2.0f;
+    const double a64 = -0.3, b64 = 11.0;
+    for (size_t i = 0; i < n; ++i) { ref[i] = dst[i]; ref64[i] = d64[i]; }
+    CHECK(parallel_affine_f32(pool, dst, dst, n, a, b, options) == 0);
+    CHECK(parallel_affine_f64(pool, d64, d64, n, a64, b64, options) == 0);
+    for (size_t i = 0; i < n; ++i)
+    {
+        CHECK(near_f(dst[i], (double)(a * ref[i] + b), a, ref[i], 2e-7));
+        CHECK(near_f(d64[i], a64 * ref64[i] + b64, a64, ref64[i], 4e-16));
+    }
+    check_guard((unsigned char *)dst, n * sizeof(float));
+    check_guard((unsigned char *)d64, n * sizeof(double));
+
+    free(rs); free(rs64); free(ref); free(ref64);
+    if (!in_place) { free(rd); free(rd64); }
+}
+
+static void check_bytes(parallel_pool *pool, size_t n, size_t soff, size_t doff, int options)
+{
+    uint64_t seed = 77 + n + soff;
+    unsigned char *rs, *rd;
+    unsigned char *src = guarded(&rs, n, soff);
+    unsigned char *dst = guarded(&rd, n, doff);
+    unsigned char lut[256];
+    for (size_t i = 0; i < n; ++i) src[i] = (unsigned char)test_rand(&seed);
+    for (int i = 0; i < 256; ++i) lut[i] = (unsigned char)(i * 37 + 11);
+
+    const unsigned char c = 0x5c;
+    CHECK(parallel_transform_u8(pool, dst, src, n, xor_u8, (void *)&c, options) == 0);
+    for (size_t i = 0; i < n; ++i) CHECK(dst[i] == (src[i] ^ c));
+    check_guard(dst, n);
+
+    CHECK(parallel_lut_u8(pool, dst, src, n, lut, options) == 0);
+    for (size_t i = 0; i < n; ++i) CHECK(dst[i] == lut[src[i]]);
+    check_guard(dst, n);
+
+    CHECK(parallel_copy(pool, dst, src, n, options) == 0);
+    CHECK(n == 0 || memcmp(dst, src, n) == 0);
+    check_guard(dst, n);
+    free(rs); free(rd);
+}
+
+static void check_fill(parallel_pool *pool, size_t n, size_t esize, size_t off, int options)
+{
+    unsigned char value[128], *raw;
+    for (size_t i = 0; i < esize; ++i) value[i] = (unsigned char)(i * 13 + esize);
+    unsigned char *dst = guarded(&raw, n * esize, off);
+    CHECK(parallel_fill(pool, dst, value, esize, n, options) == 0);
+    for (size_t i = 0; i < n; ++i) CHECK(memcmp(dst + i * esize, value, esize) == 0);
+    check_guard(dst, n * esize);
+    free(raw);
+}
+
+/* NT store 경로: PARALLEL_ARRAY_NT_BYTES 보다 크게, 어긋난 자리에서 */
+static void check_large(parallel_pool *pool)
+{
+    const size_t bytes = (size_t)PARALLEL_ARRAY_NT_BYTES + 4099;
+    unsigned char *rs, *rd;
+    unsigned char *src = guarded(&rs, bytes, 3);
+    unsigned char *dst = guarded(&rd, bytes, 17);
+    uint64_t seed = 3;
+    for (size_t i = 0; i < bytes; i += 8) { uint64_t r = test_rand(&seed); memcpy(src + i, &r, bytes - i < 8 ? bytes - i : 8); }
+    CHECK(parallel_copy(pool, dst, src, bytes, 0) == 0);
+    CHECK(memcmp(dst, src, bytes) == 0);
+    check_guard(dst, bytes);
+
+    const size_t esize = 12, n = bytes / esize;
+    unsigned char value[12] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+    memset(dst, POISON, bytes + GUARD);
+    CHECK(parallel_fill(pool, dst, value, esize, n, 0) == 0);
+    for (size_t i = 0; i < n; ++i) CHECK(memcmp(dst + i * esize, value, esize) == 0);
+    check_guard(dst, n * esize);
+    free(rs); free(rd);
+}
+
+int main(void)
+{
+    const char *isa = parallel_array_isa();
+    const char *want = getenv("PARALLEL_ISA");
+    if (want && !strcmp(want, "scalar")) CHECK(!strcmp(isa, "scalar"));
+    if (want && !strcmp(want, "avx2")) CHECK(!strcmp(isa, "avx2") || !strcmp(isa, "scalar"));
+
+    parallel_pool *pool = parallel_pool_create(3, 0);
+    CHECK(pool);
+    const size_t esizes[] = { 1, 2, 3, 4, 8, 12, 16, 64, 100 };
+    for (int si = 0; si < NSIZES; ++si)
+    {
+        const size_t n = sizes[si];
+        const int sched = test_scheds[si % TEST_NSCHEDS];
+        parallel_pool *p = si % 3 ? pool : NULL;
+        check_float(p, n, 0, sched);
+        check_float(p, n, 1, sched);
+        for (size_t off = 0; off < 64; off += (n > 1000 ? 13 : 1))
+            check_bytes(p, n, (off * 7) % 64, off, sched);
+        for (int e = 0; e < 9; ++e) check_fill(p, n, esizes[e], (size_t)(e * 5 + si) % 64, sched);
+    }
+    check_large(pool);
+    parallel_pool_destroy(pool);
+    printf("test_array (%s): ok\n", isa);
+    return 0;
+}
@@ -0,0 +1,159 @@
+/* test_scan.c — parallel_scan / parallel_reduce 를 직렬 결과와 비교 */
+#include "check.h"
+#include <string.h>
+
+static const long sizes[] = { 0, 1, 2, 3, 7, 4095, 4097, 12345, 100003 };
+#define NSIZES ((int)(sizeof(sizes) / sizeof(sizes[0])))
+
+/* 2x2 행렬 곱 (mod 2^32): 결합법칙만 있고 교환법칙은 없다. 원소는 정렬을 믿지 않고 memcpy 로 */
+typedef struct { uint32_t m[4]; } mat2;
+
+static void mat_mul(void *acc, const void *other, void *userdata)
+{
+    (void)userdata;
+    mat2 a, b, r;
+    memcpy(&a, acc, sizeof(a));
+    memcpy(&b, other, sizeof(b));
+    r.m[0] = a.m[0] * b.m[0] + a.m[1] * b.m[2];
+    r.m[1] = a.m[0] * b.m[1] + a.m[1] * b.m[3];
+    r.m[2] = a.m[2] * b.m[0] + a.m[3] * b.m[2];
+    r.m[3] = a.m[2] * b.m[1] + a.m[3] * b.m[3];
+    memcpy(acc, &r, sizeof(r));
+}
+
+static void check_long(parallel_pool *pool, long n, long chunk, int nthreads, int options, int off, int in_place)
+{
+    uint64_t seed = 0x9e3779b97f4a7c15ULL ^ (uint64_t)n;
+    long *inbuf = (long *)malloc((size_t)(n + 8) * sizeof(long));
+    long *outbuf = (long *)malloc((size_t)(n + 8) * sizeof(long));
+    long *ref = (long *)malloc((size_t)(n + 1) * sizeof(long));
+    CHECK(inbuf && outbuf && ref);
+    long *in = inbuf + off, *out = in_place ? in : outbuf + off;
+    for (long i = 0; i < n; ++i) in[i] = (long)(test_rand(&seed) % 2001) - 1000;
+
+    const int incl = options & PARALLEL_OPT_SCAN_INCLUSIVE;
+    long run = 0;
+    for (long i = 0; i < n; ++i) { if (incl) run += in[i]; ref[i] = run; if (!incl) run += in[i]; }
+
+    long total = -1;
+    int rc = pool ? parallel_pool_scan_long(pool, in, out, n, chunk, options, &total)
+                  : parallel_scan_long(in, out, n, chunk, nthreads, options, &total);
+    CHECK(rc == 0);
+    CHECK(total == run);
+    for (long i = 0; i < n; ++i) CHECK(out[i] == ref[i]);
+    free(inbuf); free(outbuf); free(ref);
+}
+
+static void check_generic(parallel_pool *pool, long n, long chunk, int options)
+{
+    // 원소를 홀수 바이트 위치에 둔다
+    uint64_t seed = 12345 + (uint64_t)n;
+    unsigned char *inbuf = (unsigned char *)malloc((size_t)(n + 1) * sizeof(mat2) + 1);
+    unsigned char *outbuf = (unsigned char *)malloc((size_t)(n + 1) * sizeof(mat2) + 1);
+    CHECK(inbuf && outbuf);
+    unsigned char *in = inbuf + 1, *out = outbuf + 1;
+    for (long i = 0; i < n; ++i)
+    {
+        mat2 m;
+        for (int k = 0; k < 4; ++k) m.m[k] = (uint32_t)test_rand(&seed);
+        memcpy(in + (size_t)i * sizeof(mat2), &m, sizeof(m));
+    }
+    const mat2 id = { { 1, 0, 0, 1 } };
+    mat2 total, acc = id;
+    int rc = pool ? parallel_pool_scan(pool, in, out, n, chunk, options, &id, sizeof(mat2), mat_mul, NULL, &total)
+                  : parallel_scan(in, out, n, chunk, 0, options, &id, sizeof(mat2), mat_mul, NULL, &total);
+    CHECK(rc == 0);
+    const int incl = options & PARALLEL_OPT_SCAN_INCLUSIVE;
+    for (long i = 0; i < n; ++i)
+    {
+        if (incl) mat_mul(&acc, in + (size_t)i * sizeof(mat2), NULL);
+        CHECK(memcmp(out + (size_t)i * sizeof(mat2), &acc, sizeof(mat2)) == 0);
+        if (!incl) mat_mul(&acc, in + (size_t)i * sizeof(mat2), NULL);
+    }
+    CHECK(memcmp(&total, &acc, sizeof(mat2)) == 0);
+    free(inbuf); free(outbuf);
+}
+
+/* reduce: 비교환 결합도 블록 순서대로 합쳐져야 하고, 부동소수점 합은 스케줄과 무관해야 한다 */
+static const double *rx;
+
+static void sum_map(long start, long stop, void *acc, void *userdata)
+{
+    (void)userdata;
+    double a = *(double *)acc;
+    for (long i = start; i < stop; ++i) a += rx[i];
+    *(double *)acc = a;
+}
+
+static void sum_combine(void *acc, const void *other, void *userdata)
+{
+    (void)userdata;
+    *(double *)acc += *(const double *)other;
+}
+
+static void mat_map(long start, long stop, void *acc, void *userdata)
+{
+    const unsigned char *in = (const unsigned char *)userdata;
+    for (long i = start; i < stop; ++i) mat_mul(acc, in + (size_t)i * sizeof(mat2), NULL);
+}
+
+static void check_reduce(parallel_pool *pool)
+{
+    const long n = 1L << 20;
+    double *x = (double *)malloc((size_t)n * sizeof(double));
+    mat2 *m = (mat2 *)malloc((size_t)n * sizeof(mat2));
+    CHECK(x && m);
+    uint64_t seed = 7;
+    for (long i = 0; i < n; ++i)
+    {
+        x[i] = ((double)(test_rand(&seed) >> 11) / 9007199254740992.0 - 0.5) * 1e12 * (double)(i % 7 + 1);
+        for (int k = 0; k < 4; ++k) m[i].m[k] = (uint32_t)test_rand(&seed);
+    }
+    rx = x;
+    const double zero = 0;
+    const mat2 id = { { 1, 0, 0, 1 } };
+    mat2 ref = id;
+    for (long i = 0; i < n; ++i) mat_mul(&ref, &m[i], NULL);
+
+    double first = 0;
+    for (int r = 0; r < 3 * TEST_NSCHEDS; ++r)
+    {
+        const int sched = test_scheds[r % TEST_NSCHEDS];
+        double s;
+        int rc = r % 2 ? parallel_pool_reduce(pool, 0, n, 1000, sched, &zero, sizeof(zero), sum_map, sum_combine, NULL, &s)
+                       : parallel_reduce(0, n, 1000, 1 + r % 4, sched, &zero, sizeof(zero), sum_map, sum_combine, NULL, &s);
+        CHECK(rc == 0);
+        if (r == 0) first = s;
+        CHECK(memcmp(&s, &first, sizeof(s)) == 0);
+
+        mat2 p;
+        CHECK(parallel_pool_reduce(pool, 0, n, 1 + r, sched, &id, sizeof(id), mat_map, mat_mul, m, &p) == 0);
+        CHECK(memcmp(&p, &ref, sizeof(p)) == 0);
+    }
+    double e = -1;
+    CHECK(parallel_reduce(5, 5, 1, 0, 0, &zero, sizeof(zero), sum_map, sum_combine, NULL, &e) == 0 && e == 0);
+    free(x); free(m);
+}
+
+int main(void)
+{
+    parallel_pool *pool = parallel_pool_create(3, 0);
+    CHECK(pool);
+    const long chunks[] = { 0, 1, 7, 1000 };
+    for (int si = 0; si < NSIZES; ++si)
+        for (int s = 0; s < TEST_NSCHEDS; ++s)
+            for (int c = 0; c < 4; ++c)
+                for (int incl = 0; incl < 2; ++incl)
+                {
+                    const long n = sizes[si];
+                    const int opt = test_scheds[s] | (incl ? PARALLEL_OPT_SCAN_INCLUSIVE : 0);
+                    const int off = (si + c) % 4;      // 64B 에 안 맞는 시작
+                    check_long(pool, n, chunks[c], 0, opt, off, (s + c) % 2);
+                    check_long(NULL, n, chunks[c], 1 + (s + c) % 4, opt, off, 0);
+                    if (c % 2 == 0) check_generic(c ? NULL : pool, n, chunks[c], opt);
+                }
+    check_reduce(pool);
+    parallel_pool_destroy(pool);
+    puts("test_scan: ok");
+    return 0;
+}
@@ -0,0 +1,135 @@
+/* test_sort.c — parallel_sort* 를 qsort 와 비교하고 안정성을 확인 */
+#include "check.h"
+#include "parallel_sort.h"
+#include <string.h>
+
+static const size_t sizes[] = { 0, 1, 2, 5, 100, 8191, 8192, 8193, 20011, 65535 };
+#define NSIZES ((int)(sizeof(sizes) / sizeof(sizes[0])))
+
+enum { PAT_RANDOM, PAT_EQUAL, PAT_SORTED, PAT_REVERSE, PAT_FEW, PAT_HIGH, NPATS };
+
+/* 레코드: (key, idx) 와 idx 로 채운 꼬리. 4 바이트면 16 비트씩 */
+static uint32_t rec_key(const unsigned char *p, size_t size)
+{
+    if (size == 4) { uint16_t k; memcpy(&k, p, 2); return k; }
+    uint32_t k; memcpy(&k, p, 4); return k;
+}
+
+static uint32_t rec_idx(const unsigned char *p, size_t size)
+{
+    if (size == 4) { uint16_t i; memcpy(&i, p + 2, 2); return i; }
+    uint32_t i; memcpy(&i, p + 4, 4); return i;
+}
+
+static void rec_make(unsigned char *p, size_t size, uint32_t key, uint32_t idx)
+{
+    if (size == 4) { uint16_t k = (uint16_t)key, i = (uint16_t)idx; memcpy(p, &k, 2); memcpy(p + 2, &i, 2); return; }
+    memcpy(p, &key, 4);
+    memcpy(p + 4, &idx, 4);
+    for (size_t b = 8; b < size; ++b) p[b] = (unsigned char)(idx * 31 + b);
+}
+
+static int cmp_key(const void *a, const void *b, void *userdata)
+{
+    const size_t size = *(const size_t *)userdata;
+    uint32_t x = rec_key((const unsigned char *)a, size), y = rec_key((const unsigned char *)b, size);
+    return (x > y) - (x < y);
+}
+
+static uint32_t pattern(int pat, size_t i, size_t n, uint64_t *seed)
+{
+    switch (pat)
+    {
+    case PAT_EQUAL:   return 42;
+    case PAT_SORTED:  return (uint32_t)i;
+    case PAT_REVERSE: return (uint32_t)(n - i);
+    case PAT_FEW:     return (uint32_t)(test_rand(seed) % 5);
+    case PAT_HIGH:    return (uint32_t)(test_rand(seed) >> 56) << 24;
+    default:          return (uint32_t)test_rand(seed);
+    }
+}
+
+static void check_cmp(parallel_pool *pool, size_t n, size_t size, int pat, int options)
+{
+    uint64_t seed = 1 + n * 7 + size;
+    unsigned char *a = (unsigned char *)malloc(n * size + 1);
+    void *scratch = (pat & 1) ? malloc(parallel_sort_scratch_size(n, size) + 1) : NULL;
+    CHECK(a);
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint32_t k = pattern(pat, i, n, &seed);
+        if (size == 4) k &= 0xffff;
+        rec_make(a + i * size, size, k, (uint32_t)i);
+    }
+    CHECK(parallel_sort(pool, a, n, size, cmp_key, &size, scratch, options) == 0);
+    // 안정 정렬이면 (key, idx) 사전식 순서 = qsort 로 (key, idx) 정렬한 결과
+    for (size_t i = 0; i < n; ++i)
+    {
+        const unsigned char *p = a + i * size;
+        unsigned char want[64];
+        rec_make(want, size, rec_key(p, size), rec_idx(p, size));
+        CHECK(memcmp(p, want, size) == 0);
+        if (i == 0) continue;
+        const unsigned char *q = p - size;
+        CHECK(rec_key(q, size) < rec_key(p, size) ||
+              (rec_key(q, size) == rec_key(p, size) && rec_idx(q, size) < rec_idx(p, size)));
+    }
+    free(a); free(scratch);
+}
+
+#define DEFINE_RADIX_CHECK(name, T, fn, gen)                                               \
+    static int name##_qcmp(const void *a, const void *b)                                   \
+    {                                                                                      \
+        T x = *(const T *)a, y = *(const T *)b;                                            \
+        return (x > y) - (x < y);                                                          \
+    }                                                                                      \
+    static void name(parallel_pool *pool, size_t n, int pat, int options)                  \
+    {                                                                                      \
+        uint64_t seed = 99 + n * 3 + (uint64_t)pat;                                        \
+        T *k = (T *)malloc(n * sizeof(T) + 1), *ref = (T *)malloc(n * sizeof(T) + 1);      \
+        void *scratch = (pat & 1) ? malloc(parallel_sort_scratch_size(n, sizeof(T))) : NULL; \
+        CHECK(k && ref);                                                                   \
+        for (size_t i = 0; i < n; ++i) { uint64_t r = pattern(pat, i, n, &seed); k[i] = (T)(gen); } \
+        memcpy(ref, k, n * sizeof(T));                                                     \
+        qsort(ref, n, sizeof(T), name##_qcmp);                                             \
+        CHECK(fn(pool, k, n, scratch, options) == 0);                                      \
+        CHECK(n == 0 || memcmp(k, ref, n * sizeof(T)) == 0);                               \
+        free(k); free(ref); free(scratch);                                                 \
+    }
+
+/* 64 비트는 위 32 비트까지 흔들고, signed 는 음수를 섞는다 */
+DEFINE_RADIX_CHECK(check_u32, uint32_t, parallel_sort_u32, r)
+DEFINE_RADIX_CHECK(check_i32, int32_t,  parallel_sort_i32, (int64_t)r - 0x80000000LL)
+DEFINE_RADIX_CHECK(check_u64, uint64_t, parallel_sort_u64, pat == PAT_HIGH ? r << 32 : r * 0x9e3779b97f4a7c15ULL)
+DEFINE_RADIX_CHECK(check_i64, int64_t,  parallel_sort_i64,
+                   pat == PAT_HIGH ? (int64_t)(r << 32) : (int64_t)(r * 0x9e3779b97f4a7c15ULL))
+
+int main(void)
+{
+    parallel_pool *pool = parallel_pool_create(3, 0);
+    CHECK(pool);
+    const size_t rsizes[] = { 4, 8, 16, 24 };
+    for (int si = 0; si < NSIZES; ++si)
+        for (int pat = 0; pat < NPATS; ++pat)
+        {
+            const size_t n = sizes[si];
+            const int sched = test_scheds[(si + pat) % TEST_NSCHEDS];
+            parallel_pool *p = (si + pat) % 2 ? pool : NULL;
+            for (int r = 0; r < 4; ++r) check_cmp(p, n, rsizes[r], pat, sched);
+            check_u32(p, n, pat, sched);
+            check_i32(p, n, pat, sched);
+            check_u64(p, n, pat, sched);
+            check_i64(p, n, pat, sched);
+        }
+    // 블록 수가 최대를 넘는 크기
+    check_u64(pool, 1000003, PAT_RANDOM, 0);
+    check_i32(pool, 1000003, PAT_FEW, 0);
+    check_cmp(pool, 300007, 16, PAT_FEW, 0);
+
+    uint32_t dummy = 0;
+    CHECK(parallel_sort(pool, &dummy, 1, 0, cmp_key, NULL, NULL, 0) == -1);
+    CHECK(parallel_sort(pool, &dummy, 1, 4, NULL, NULL, NULL, 0) == -1);
+    parallel_pool_destroy(pool);
+    puts("test_sort: ok");
+    return 0;
+}